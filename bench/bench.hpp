@@ -0,0 +1,53 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench/bench.hpp
+ * @author Haoran Luo
+ * @brief The benchmarks of the snail viewer.
+ *
+ * The benchmarks are built into a single executable when BUILD_BENCHMARK
+ * is on, which runs the benchmarks named by its arguments, or all of
+ * them if none is named. The executable replaces the global operator
+ * new, so that the benchmarks could count the allocations they make.
+ */
+#include <cstdint>
+
+namespace snailbench {
+
+/// Retrieve the number of calls to the global operator new so far.
+uint64_t allocations();
+
+/// Benchmark broadcasting small events through the buses, returning
+/// whether no allocation is made per broadcast.
+bool broadcast();
+
+/// Benchmark dispatching many built-in events through the synchronous
+/// and static buses, returning whether every event is handled.
+bool dispatch();
+
+/// Benchmark expanding a huge struct in the object tree, returning
+/// whether the rows are added and removed as expected.
+bool objectTree();
+
+/// Benchmark looking up the uids of modules in unordered maps, returning
+/// whether every uid is found.
+bool uidLookup();
+
+} // namespace snailbench.
@@ -0,0 +1,127 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench/broadcast.cpp
+ * @author Haoran Luo
+ * @brief Benchmark of broadcasting small events.
+ *
+ * The small events are copied into the holders from the pool, so no
+ * allocation should be made per broadcast once the pool is warmed up,
+ * whether the event is dispatched synchronously, asynchronously, or
+ * directly by the static bus. The instrumentation of the buses must be
+ * disabled while benchmarking, since it records on every broadcast.
+ */
+#include "bench.hpp"
+#include "snailviewer/asyncbus.hpp"
+#include "snailviewer/eventbus.hpp"
+#include "snailviewer/staticbus.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+using namespace snailviewer;
+
+// Helpers for the broadcast benchmark.
+namespace {
+
+/// The number of broadcasts to warm up the pool with, which grows until
+/// it holds as many events as the asynchronous bus has in flight.
+constexpr size_t warmups = 100000;
+
+/// The number of broadcasts measured.
+constexpr size_t rounds = 1000000;
+
+/// The small event broadcast, like a scrolling or progress event.
+struct tickEvent {
+	static constexpr uid id() {
+		return makeUid(uidType::event, "SNAIL", "HL", "BTICK");
+	}
+
+	/// The payload of the event.
+	uint64_t value, first, second;
+};
+
+/// The handler summing the payload, so that nothing is optimized out.
+class tickHandler : public eventHandler<tickEvent> {
+	/// The sum of the payload handled.
+	std::atomic<uint64_t> total;
+public:
+	/// Subscribe to the events of the bus.
+	explicit tickHandler(eventBus& bus):
+		eventHandler<tickEvent>(bus), total(0) {}
+
+	virtual void handle(const tickEvent& event) override {
+		total.fetch_add(event.value, std::memory_order_relaxed);
+	}
+
+	/// Retrieve the sum of the payload handled.
+	uint64_t sum() const noexcept { return total.load(); }
+};
+
+/// Broadcast the events through the bus, reporting the allocations and
+/// time per broadcast, and returning whether nothing is allocated. The
+/// time includes waiting for the events to be handled.
+template<typename busType> bool measure(const char* name, busType& bus) {
+	typedef std::chrono::steady_clock clock;
+	tickHandler handler(bus);
+	auto drain = [&handler](uint64_t count) {
+		while(handler.sum() < count) std::this_thread::yield();
+	};
+	for(size_t i = 0; i < warmups; ++ i) bus.broadcast(tickEvent { 1, 0, 0 });
+	drain(warmups);
+
+	uint64_t before = snailbench::allocations();
+	clock::time_point start = clock::now();
+	for(size_t i = 0; i < rounds; ++ i) bus.broadcast(tickEvent { 1, 0, 0 });
+	drain(warmups + rounds);
+	double nanos = std::chrono::duration<double, std::nano>(
+		clock::now() - start).count();
+	uint64_t allocated = snailbench::allocations() - before;
+
+	std::printf("%-8s %10.1f ns/broadcast %10llu allocations in %llu"
+		" broadcasts\n", name, nanos / rounds, (unsigned long long)allocated,
+		(unsigned long long)rounds);
+	return allocated == 0;
+}
+
+} // Anonymous namespace.
+
+bool snailbench::broadcast() {
+	bool passed = true;
+	{
+		syncEventBus bus;
+		if(bus.statistics() != nullptr) {
+			std::printf("unset %s to benchmark broadcasting\n",
+				eventStatisticsVariable);
+			return false;
+		}
+		passed &= measure("sync", bus);
+	}
+	{
+		asyncEventBus bus;
+		passed &= measure("async", bus);
+	}
+	{
+		staticEventBus<tickEvent> bus;
+		passed &= measure("static", bus);
+	}
+	return passed;
+}
@@ -0,0 +1,136 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench/dispatch.cpp
+ * @author Haoran Luo
+ * @brief Benchmark of dispatching the built-in events.
+ *
+ * The viewer has dozens of built-in events, which are broadcast round
+ * robin through the synchronous bus looking them up in the handler
+ * table, and through the static bus resolving them at compile time.
+ */
+#include "bench.hpp"
+#include "snailviewer/eventbus.hpp"
+#include "snailviewer/staticbus.hpp"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+using namespace snailviewer;
+
+// Helpers for the dispatch benchmark.
+namespace {
+
+/// The number of built-in events.
+constexpr size_t eventCount = 64;
+
+/// The number of rounds broadcasting every event once.
+constexpr size_t rounds = 100000;
+
+/// The built-in event numbered by its index.
+template<size_t index> struct numberedEvent {
+	static constexpr uid id() {
+		return uid { { 'B', 'E', 'N', 'C', 'H' }, { 'H', 'L', 0 },
+			uidType::event, { 'E', (char)('0' + index / 10),
+				(char)('0' + index % 10), 0, 0, 0, 0 } };
+	}
+
+	/// The payload of the event.
+	uint64_t value;
+};
+
+/// The handler summing the payload of the events.
+template<size_t index>
+class numberedHandler : public eventHandler<numberedEvent<index>> {
+	/// The sum of the payload handled.
+	uint64_t& total;
+public:
+	/// Subscribe to the events of the bus.
+	numberedHandler(eventBus& bus, uint64_t& total):
+		eventHandler<numberedEvent<index>>(bus), total(total) {}
+
+	virtual void handle(const numberedEvent<index>& event) override {
+		total += event.value;
+	}
+};
+
+/// The indices of the events, since C++11 has no index sequence.
+template<size_t... indices> struct indexList {};
+
+template<size_t count, size_t... indices> struct makeIndices :
+	makeIndices<count - 1, count - 1, indices...> {};
+
+template<size_t... indices> struct makeIndices<0, indices...> {
+	typedef indexList<indices...> type;
+};
+
+/// Evaluate the arguments for their side effects.
+template<typename... argTypes> void sequence(argTypes...) {}
+
+/// Subscribe the handlers of every event to the bus.
+template<size_t... indices> void subscribe(eventBus& bus, uint64_t& total,
+		std::vector<std::shared_ptr<void>>& handlers, indexList<indices...>) {
+	sequence((handlers.push_back(std::make_shared<numberedHandler<indices>>(
+		bus, total)), 0)...);
+}
+
+/// Broadcast every event once, in the order of their indices.
+template<typename busType, size_t... indices>
+void broadcastAll(busType& bus, indexList<indices...>) {
+	int order[] = { (bus.broadcast(numberedEvent<indices> { 1 }), 0)... };
+	(void)order;
+}
+
+/// The static bus of the numbered events.
+template<typename indicesType> struct staticBusOf;
+
+template<size_t... indices> struct staticBusOf<indexList<indices...>> {
+	typedef staticEventBus<numberedEvent<indices>...> type;
+};
+
+/// Broadcast every event round robin through the bus, reporting the
+/// time per broadcast and returning whether every event is handled.
+template<typename busType> bool measure(const char* name) {
+	typedef typename makeIndices<eventCount>::type indices;
+	typedef std::chrono::steady_clock clock;
+	busType bus;
+	uint64_t total = 0;
+	std::vector<std::shared_ptr<void>> handlers;
+	subscribe(bus, total, handlers, indices());
+
+	clock::time_point start = clock::now();
+	for(size_t round = 0; round < rounds; ++ round)
+		broadcastAll(bus, indices());
+	double nanos = std::chrono::duration<double, std::nano>(
+		clock::now() - start).count();
+	std::printf("%-8s %10.1f ns/broadcast over %zu events\n",
+		name, nanos / (double)(rounds * eventCount), eventCount);
+	return total == rounds * eventCount;
+}
+
+} // Anonymous namespace.
+
+bool snailbench::dispatch() {
+	bool passed = measure<syncEventBus>("sync");
+	passed &= measure<staticBusOf<makeIndices<eventCount>::type>::type>(
+		"static");
+	return passed;
+}
@@ -0,0 +1,94 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench/main.cpp
+ * @author Haoran Luo
+ * @brief Entry point of the benchmarks.
+ */
+#include "bench.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Helpers for counting the allocations.
+namespace {
+
+/// The number of calls to the global operator new.
+std::atomic<uint64_t> allocationCount(0);
+
+/// Allocate the memory for the global operator new.
+void* allocate(size_t size) {
+	++ allocationCount;
+	void* memory = std::malloc(size == 0? 1 : size);
+	if(memory == nullptr) throw std::bad_alloc();
+	return memory;
+}
+
+} // Anonymous namespace.
+
+void* operator new(size_t size) { return allocate(size); }
+void* operator new[](size_t size) { return allocate(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, size_t) noexcept { std::free(memory); }
+
+uint64_t snailbench::allocations() { return allocationCount.load(); }
+
+// Helpers for running the benchmarks.
+namespace {
+
+/// The benchmark with its name.
+struct benchmark {
+	/// The name to select the benchmark by.
+	const char* name;
+
+	/// Run the benchmark, returning whether it has passed.
+	bool (*run)();
+};
+
+/// The benchmarks in the order to run.
+const benchmark benchmarks[] = {
+	{ "broadcast", snailbench::broadcast },
+	{ "dispatch", snailbench::dispatch },
+	{ "objecttree", snailbench::objectTree },
+	{ "uidlookup", snailbench::uidLookup },
+};
+
+} // Anonymous namespace.
+
+// Implementation of the benchmark entry point.
+int main(int argc, char* argv[]) {
+	bool passed = true;
+	for(const benchmark& bench : benchmarks) {
+		bool selected = argc <= 1;
+		for(int i = 1; i < argc; ++ i)
+			if(std::strcmp(argv[i], bench.name) == 0) selected = true;
+		if(!selected) continue;
+		std::printf("== %s\n", bench.name);
+		if(!bench.run()) {
+			std::printf("%s: failed\n", bench.name);
+			passed = false;
+		}
+	}
+	return passed? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,108 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench/objecttree.cpp
+ * @author Haoran Luo
+ * @brief Benchmark of expanding huge structs in the object tree.
+ *
+ * A footprint captures a container of a million elements, each being a
+ * small struct. The container is expanded, a viewport in the middle of
+ * it is rendered, an element there is expanded, and the container is
+ * collapsed, which should all be independent of the container's size.
+ */
+#include "bench.hpp"
+#include "snailviewer/objectcache.hpp"
+#include "snailviewer/objecttree.hpp"
+#include "snailviewer/snaillog.hpp"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace snailviewer;
+
+// Helpers for the object tree benchmark.
+namespace {
+
+/// The number of elements of the container.
+constexpr uint32_t elementCount = 1000000;
+
+/// The number of rows of the viewport.
+constexpr size_t viewportRows = 50;
+
+/// Fill the log with a footprint capturing the container.
+void capture(snailLog& log) {
+	uint32_t intType = log.names.intern("int");
+	uint32_t pointType = log.names.intern("point");
+	uint32_t vectorType = log.names.intern("std::vector<point>");
+	uint32_t x = log.names.intern("x"), y = log.names.intern("y");
+	std::vector<objectField> elements(elementCount);
+	for(uint32_t i = 0; i < elementCount; ++ i) {
+		std::string first = std::to_string(i), second = std::to_string(i % 7);
+		objectField fields[2] = {
+			{ x, log.objects.addLiteral(intType, first.data(), first.size()) },
+			{ y, log.objects.addLiteral(intType, second.data(), second.size()) },
+		};
+		elements[i].name = log.names.intern("[" + std::to_string(i) + "]");
+		elements[i].object = log.objects.addStruct(pointType, fields, 2);
+	}
+	uint32_t container = log.objects.addStruct(vectorType,
+		elements.data(), elements.size());
+	log.bindings.push_back(objectBinding { log.names.intern("local"),
+		log.names.intern("points"), container });
+	log.footprints.push_back(absent, absent, absent, absent, 1);
+}
+
+/// Retrieve the microseconds spent by the operation.
+template<typename operationType> double time(operationType operation) {
+	typedef std::chrono::steady_clock clock;
+	clock::time_point start = clock::now();
+	operation();
+	return std::chrono::duration<double, std::micro>(
+		clock::now() - start).count();
+}
+
+} // Anonymous namespace.
+
+bool snailbench::objectTree() {
+	snailLog log;
+	capture(log);
+	objectCache cache(log);
+	objectTreeModel model;
+	model.reset(log, 0, cache);
+
+	// The rows are the scope, the container and then its elements.
+	size_t added = 0, removed = 0, nested = 0, rendered = 0;
+	size_t middle = 2 + elementCount / 2;
+	double expanding = time([&]() { added = model.expand(1); });
+	double rendering = time([&]() {
+		for(size_t row = middle; row < middle + viewportRows; ++ row)
+			rendered += model.text(model.at(row), 80).size();
+	});
+	double nesting = time([&]() { nested = model.expand(middle); });
+	double collapsing = time([&]() { removed = model.collapse(1); });
+
+	std::printf("expand %u elements: %10.2f us\n", elementCount, expanding);
+	std::printf("render %zu rows:      %10.2f us\n", viewportRows, rendering);
+	std::printf("expand an element:    %10.2f us\n", nesting);
+	std::printf("collapse:             %10.2f us\n", collapsing);
+	return added == elementCount && nested == 2 && rendered > 0 &&
+		removed == elementCount + nested && model.rows() == 2;
+}
@@ -0,0 +1,126 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file bench/uidlookup.cpp
+ * @author Haoran Luo
+ * @brief Benchmark of looking up uids in unordered maps.
+ *
+ * The uids are generated like the ones of modules: a few modules and
+ * authors, each with their entities of every type named by counters,
+ * so they share most of their bytes. The hash of the uids is compared
+ * with the former hash, which xors the halves of the uid, by how fast
+ * they are looked up in unordered maps, and by how they are distributed
+ * into tables of power of 2 slots like the handler tables, which keep
+ * only the low bits unlike the prime bucket counts of unordered maps.
+ */
+#include "bench.hpp"
+#include "snailviewer/uid.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+
+using namespace snailviewer;
+
+// Helpers for the uid lookup benchmark.
+namespace {
+
+/// The number of entities of each type per module.
+constexpr size_t entitiesPerType = 200;
+
+/// The number of times every uid is looked up.
+constexpr size_t rounds = 1000;
+
+/// The number of slots of the table the hashes are distributed into,
+/// which is the power of 2 keeping the load factor under a half.
+constexpr size_t slotCount = 16384;
+
+/// The former hash of the uids, which xors their halves.
+struct xorHash {
+	size_t operator()(const uid& id) const noexcept {
+		uint64_t halves[2];
+		std::memcpy(halves, &id, sizeof(halves));
+		return (size_t)(halves[0] ^ halves[1]);
+	}
+};
+
+/// Generate the uids of the modules.
+std::vector<uid> generate() {
+	const char* modules[] = { "SNAIL", "LUAMD", "PYMOD", "GDBX" };
+	const char* authors[] = { "HL", "ABC" };
+	const uidType types[] = { uidType::module, uidType::event,
+		uidType::widget, uidType::keybind, uidType::color };
+	std::vector<uid> ids;
+	for(const char* module : modules) for(const char* author : authors)
+	for(uidType type : types) for(size_t i = 0; i < entitiesPerType; ++ i) {
+		uid id = null(type);
+		std::memcpy(id.module, module, std::strlen(module));
+		std::memcpy(id.author, author, std::strlen(author));
+		char name[sizeof(id.name) + 1];
+		std::snprintf(name, sizeof(name), "E%06zu", i);
+		std::memcpy(id.name, name, sizeof(id.name));
+		ids.push_back(id);
+	}
+	return ids;
+}
+
+/// Measure the hash over the uids, returning whether every uid is found.
+template<typename hashType>
+bool measure(const char* name, const std::vector<uid>& ids) {
+	// Insert the hashes into the table by linear probing.
+	std::vector<bool> slots(slotCount, false);
+	hashType hash;
+	size_t probes = 0;
+	for(const uid& id : ids) {
+		size_t i = hash(id) & (slotCount - 1);
+		for(; slots[i]; i = (i + 1) & (slotCount - 1)) ++ probes;
+		slots[i] = true;
+	}
+
+	// Look up every uid in the map.
+	typedef std::chrono::steady_clock clock;
+	std::unordered_map<uid, size_t, hashType> map;
+	for(size_t i = 0; i < ids.size(); ++ i) map[ids[i]] = i;
+	size_t found = 0;
+	clock::time_point start = clock::now();
+	for(size_t round = 0; round < rounds; ++ round)
+		for(size_t i = 0; i < ids.size(); ++ i) {
+			auto it = map.find(ids[i]);
+			if(it != map.end() && it->second == i) ++ found;
+		}
+	double nanos = std::chrono::duration<double, std::nano>(
+		clock::now() - start).count();
+
+	std::printf("%-8s %10.1f ns/lookup %10.2f probes/insert in %zu slots\n",
+		name, nanos / (double)(rounds * ids.size()),
+		(double)probes / (double)ids.size(), slotCount);
+	return found == rounds * ids.size();
+}
+
+} // Anonymous namespace.
+
+bool snailbench::uidLookup() {
+	std::vector<uid> ids = generate();
+	std::printf("%zu uids\n", ids.size());
+	bool passed = measure<std::hash<uid>>("hash", ids);
+	passed &= measure<xorHash>("xor", ids);
+	return passed;
+}
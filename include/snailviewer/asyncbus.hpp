@@ -0,0 +1,126 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/asyncbus.hpp
+ * @author Haoran Luo
+ * @brief The event bus broadcasting events on a dedicated thread.
+ *
+ * The background loaders, indexers and searchers raise progress events
+ * far more often than the user interface could handle them, and they
+ * should never wait for the handlers. So the events are posted into a
+ * bounded lock-free queue, and broadcast on the dispatcher thread of
+ * the bus in the order they are posted.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/eventbus.hpp"
+#include "snailviewer/mpscqueue.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+
+namespace snailviewer {
+
+/**
+ * @brief The event bus broadcasting events asynchronously.
+ *
+ * The events could be raised on any thread, and they are broadcast on
+ * the dispatcher thread. Raising an event never blocks unless the queue
+ * is full, where the raising thread yields until there's room.
+ *
+ * The handlers may subscribe and unsubscribe on any thread. Once the
+ * unsubscription returns, the handler is never invoked again. The
+ * handlers must not throw, since there's nobody to catch it on the
+ * dispatcher thread.
+ *
+ * Destroying the bus broadcasts the events still in the queue.
+ */
+class asyncEventBus : public eventBus {
+	/// The event waiting to be broadcast.
+	struct pendingEvent {
+		/// The uid of the event.
+		uid id;
+
+		/// The holder of the event, owned by the queue.
+		eventHolder* holder;
+	};
+
+	/// The queue of the events waiting to be broadcast.
+	mpscQueue<pendingEvent> queue;
+
+	/// The handlers of the events.
+	handlerTable handlers;
+
+	/// The mutex guarding the handlers, which is recursive since the
+	/// handlers may subscribe or unsubscribe while being invoked.
+	std::recursive_mutex handlerMutex;
+
+	/// The mutex and condition for the dispatcher to sleep on.
+	std::mutex sleepMutex;
+	std::condition_variable wakeup;
+
+	/// Whether the dispatcher is sleeping or going to sleep.
+	std::atomic<bool> sleeping;
+
+	/// Whether the bus is being destroyed.
+	std::atomic<bool> stopping;
+
+	/// The dispatcher thread, which is started after all other members.
+	std::thread dispatcher;
+
+	/// The routine of the dispatcher thread.
+	void run();
+
+	/// Broadcast the event to its handlers and destroy it.
+	void deliver(const pendingEvent& event);
+
+	virtual void subscribe(uid id, eventHandler<void*>& h) override;
+	virtual void unsubscribe(uid id, eventHandler<void*>& h) override;
+	virtual void broadcast(uid id, std::unique_ptr<eventHolder> evh) override;
+public:
+	/// The default capacity of the queue.
+	static constexpr size_t defaultCapacity = 4096;
+
+	/// Start the bus with the capacity of its queue, which must be a
+	/// power of 2.
+	explicit asyncEventBus(size_t capacity = defaultCapacity);
+
+	/// Broadcast the remaining events and stop the dispatcher.
+	virtual ~asyncEventBus();
+
+	/// Broadcast strongly typed events.
+	using eventBus::broadcast;
+
+	/// Retrieve the approximate number of events in the queue.
+	size_t pending() const noexcept { return queue.size(); }
+
+	/// Retrieve the statistics of the bus, or null if not instrumented.
+	eventStatistics* statistics() const noexcept { return handlers.statistics(); }
+
+	/// Set the activator of the events, which should be done before the
+	/// bus is shared among threads.
+	void activateBy(eventActivator* activator) noexcept {
+		handlers.activateBy(activator);
+	}
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,151 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/backgroundloader.hpp
+ * @author Haoran Luo
+ * @brief Loading the snail log on a background thread.
+ *
+ * A log of gigabytes takes seconds to load, while its first footprints
+ * are loaded in milliseconds. So the log is loaded on a background
+ * thread, and the footprints loaded are announced through the event
+ * bus in ranges, so that they could be browsed while the rest of the
+ * log is still loading.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/loader.hpp"
+#include "snailviewer/snaillog.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <string>
+#include <thread>
+
+namespace snailviewer {
+
+/**
+ * @brief The event that the log is opened and its footprints are
+ * being loaded, see also loadObserver for what could be read.
+ */
+struct logOpenedEvent {
+	static constexpr uid id() {
+		return makeUid(uidType::event, "SNAIL", "HL", "LOGOPEN");
+	}
+
+	/// The log opened.
+	const snailLog* log;
+
+	/// The number of footprints to load, or unknownFootprints.
+	size_t footprints;
+
+	/// Whether the objects of footprints are decoded lazily, which other
+	/// threads must tell from here since the tables of the log grow. It
+	/// is false for binary logs, whatever the options are.
+	bool lazy;
+};
+
+/**
+ * @brief The event that the footprints [begin, end) are loaded, after
+ * all the footprints before them.
+ */
+struct footprintsLoadedEvent {
+	static constexpr uid id() {
+		return makeUid(uidType::event, "SNAIL", "HL", "FPLOAD");
+	}
+
+	static constexpr eventPriority priority = eventPriority::background;
+
+	/// The range of footprints loaded.
+	uint32_t begin, end;
+
+	/// The number of footprints to load, or unknownFootprints.
+	size_t total;
+};
+
+/**
+ * @brief The event that loading the log is finished, when the whole
+ * log could be read, or failed.
+ */
+struct logLoadedEvent {
+	static constexpr uid id() {
+		return makeUid(uidType::event, "SNAIL", "HL", "LOGDONE");
+	}
+
+	/// The log loaded.
+	const snailLog* log;
+
+	/// The error raised while loading, or null if loaded.
+	std::exception_ptr error;
+};
+
+/**
+ * @brief The loader of the snail log on a background thread.
+ *
+ * The events are raised on the loading thread, so the bus must accept
+ * events from other threads. The events are raised in order: the log
+ * is opened, the footprints are loaded in ranges and the loading is
+ * finished. On failure, the finish is raised right after the failure.
+ *
+ * Destroying the loader cancels the loading and waits for the thread.
+ */
+class backgroundLoader : private loadObserver {
+	/// The bus to raise the events.
+	eventBus& bus;
+
+	/// The log being loaded.
+	snailLog log;
+
+	/// The number of footprints to load, known once opened.
+	size_t total;
+
+	/// Whether the loading is cancelled.
+	std::atomic<bool> cancelled;
+
+	/// The loading thread.
+	std::thread worker;
+
+	/// The routine of the loading thread.
+	void load(std::string path, loadOptions options);
+
+	virtual void opened(const snailLog& log,
+		size_t footprints, bool lazy) override;
+	virtual void loaded(const snailLog& log, uint32_t begin, uint32_t end) override;
+public:
+	/**
+	 * @brief Start loading the file of either JSON or binary format.
+	 *
+	 * The observer of the options is replaced by the loader.
+	 */
+	backgroundLoader(eventBus& bus, const std::string& path,
+		loadOptions options = loadOptions());
+
+	/// Cancel the loading and wait for the thread.
+	~backgroundLoader();
+
+	backgroundLoader(const backgroundLoader&) = delete;
+	backgroundLoader& operator=(const backgroundLoader&) = delete;
+
+	/// Retrieve the log being loaded, see also the events for which
+	/// part of it could be read.
+	const snailLog& target() const noexcept { return log; }
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,282 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/binary.hpp
+ * @author Haoran Luo
+ * @brief The binary encoding of snail logs (".snailb").
+ *
+ * The binary snail log is a header, a directory of sections and the
+ * sections, where each section is exactly the content of an in-memory
+ * table. So opening a binary snail log is mapping the file and pointing
+ * the tables into it, nothing is parsed or copied.
+ *
+ * The records are stored in the byte order of the machine writing
+ * the file, and the reader rejects the file of foreign byte order.
+ *
+ * The footprints are stored column by column like the in-memory table.
+ */
+#include "snailviewer/snaillog.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/// The magic number at the beginning of the binary snail logs.
+constexpr char binaryMagic[8] = { 'S', 'N', 'A', 'I', 'L', 'B', '\r', '\n' };
+
+/// The version of the binary snail log format.
+constexpr uint32_t binaryVersion = 1;
+
+/// The marker for detecting the byte order of the binary snail logs.
+constexpr uint32_t binaryByteOrder = 0x01020304u;
+
+/**
+ * @brief The header of the binary snail log.
+ */
+struct binaryHeader {
+	/// The magic number, which must be binaryMagic.
+	char magic[8];
+
+	/// The byte order marker written in the writer's byte order.
+	uint32_t byteOrder;
+
+	/// The version of the format.
+	uint32_t version;
+
+	/// The number of sections in the directory following the header.
+	uint32_t sectionCount;
+
+	/// Reserved for future use, must be zero.
+	uint32_t reserved;
+};
+
+/**
+ * @brief The kind of the sections. The unknown sections are ignored.
+ */
+enum class sectionKind : uint32_t {
+	/// String table of the version and the root of the log.
+	meta = 1,
+
+	/// String table of the source files.
+	files,
+
+	/// String table of the function names.
+	functions,
+
+	/// String table of the names.
+	names,
+
+	/// Table of the object nodes.
+	objectNodes,
+
+	/// Table of the struct fields.
+	objectFields,
+
+	/// The JSON text of literals.
+	objectHeap,
+
+	/// Table of the object ids of the root "objects" array.
+	rootObjects,
+
+	/// Table of the bindings.
+	bindings,
+
+	/// Column of the footprint parents.
+	footprintParents,
+
+	/// Column of the footprint files.
+	footprintFiles,
+
+	/// Column of the footprint lines.
+	footprintLines,
+
+	/// Column of the footprint functions.
+	footprintFunctions,
+
+	/// Column of the footprint binding offsets, with one more entry.
+	footprintBindings,
+
+	/// Optional columns of the footprint tree index, which is built
+	/// while opening if any of them is absent.
+	treeChildOffsets,
+	treeChildren,
+	treeDepths,
+	treeEnters,
+	treeLeaves,
+	treeOrders,
+};
+
+/**
+ * @brief The entry of the section directory.
+ *
+ * The sections are aligned to 8 bytes. A string table section holds
+ * count + 1 offsets of 64-bit followed by the characters.
+ */
+struct binarySection {
+	/// The kind of the section.
+	sectionKind kind;
+
+	/// Reserved for future use, must be zero.
+	uint32_t reserved;
+
+	/// The offset of the section from the beginning of the file.
+	uint64_t offset;
+
+	/// The size of the section in bytes.
+	uint64_t size;
+
+	/// The number of records or strings inside the section.
+	uint64_t count;
+};
+
+/**
+ * @brief The error raised when the binary snail log is malformed.
+ */
+class formatError : public std::runtime_error {
+public:
+	/// Construct the error with the message.
+	formatError(const std::string& message): std::runtime_error(message) {}
+};
+
+/**
+ * @brief Whether the content is likely to be a binary snail log.
+ */
+bool isBinaryLog(const char* data, size_t size) noexcept;
+
+/**
+ * @brief Open the binary snail log by borrowing from the mapped file.
+ *
+ * Besides the layout of the file, the references of the records are
+ * validated in a linear pass, so that a truncated or corrupt file is
+ * rejected instead of being read outside the tables.
+ *
+ * @param[in] file the mapped file, which is moved into the log.
+ * @param[out] log the log to open, which should be empty.
+ * @throw formatError when the file is not a valid binary snail log.
+ */
+void loadBinary(mappedFile file, snailLog& log);
+
+/**
+ * @brief Open the binary snail log file.
+ *
+ * @throw formatError when the file is not a valid binary snail log.
+ * @throw std::system_error when the file cannot be mapped.
+ */
+void loadBinaryFile(const std::string& path, snailLog& log);
+
+/**
+ * @brief The writer of binary snail log files section by section.
+ *
+ * The room of the directory is left after the header, and the sections
+ * follow in the order they are written, so that a section could be
+ * appended piece by piece while it is still being produced. The header
+ * and the directory are patched in when the file is closed.
+ */
+class binaryLogWriter {
+	/// The file being written.
+	FILE* file;
+
+	/// The path of the file.
+	std::string path;
+
+	/// The directory of the sections written, where the last one is
+	/// still being written if the section is open.
+	std::vector<binarySection> directory;
+
+	/// Whether the last section of the directory is being written.
+	bool open;
+
+	/// The offset of the end of the file.
+	uint64_t offset;
+
+	/// Raise the error from errno.
+	[[noreturn]] void fail();
+
+	/// Write the content at the end of the file.
+	void write(const void* data, size_t size);
+public:
+	/**
+	 * @brief Create the file and leave the room of the directory.
+	 *
+	 * @throw std::system_error when the file cannot be written.
+	 */
+	explicit binaryLogWriter(const std::string& path);
+
+	/// Close the file if it has not been closed, leaving it incomplete.
+	~binaryLogWriter();
+
+	binaryLogWriter(const binaryLogWriter&) = delete;
+	binaryLogWriter& operator=(const binaryLogWriter&) = delete;
+
+	/**
+	 * @brief Begin writing the section of the kind.
+	 *
+	 * @throw std::logic_error when a section is being written, or the
+	 * section of the kind has been written.
+	 */
+	void begin(sectionKind kind);
+
+	/// Append the content of the section being written, which is made
+	/// up of the number of records or strings.
+	void append(const void* data, size_t size, size_t count);
+
+	/// Finish writing the section.
+	void end();
+
+	/// Whether the section of the kind has been written.
+	bool written(sectionKind kind) const noexcept;
+
+	/// Write the section of the table.
+	template<typename valueType>
+	void writeTable(sectionKind kind, const table<valueType>& records) {
+		begin(kind);
+		append(records.data(), records.size() * sizeof(valueType),
+			records.size());
+		end();
+	}
+
+	/// Write the section of the string table.
+	void writeStrings(sectionKind kind, const stringTable& strings);
+
+	/**
+	 * @brief Write the sections of the log which have not been written.
+	 *
+	 * @throw std::invalid_argument when the log is loaded with lazy objects.
+	 */
+	void writeLog(const snailLog& log);
+
+	/// Patch in the header and the directory, and close the file.
+	void close();
+};
+
+/**
+ * @brief Write the snail log as a binary snail log file.
+ *
+ * @throw std::invalid_argument when the log is loaded with lazy objects.
+ * @throw std::system_error when the file cannot be written.
+ */
+void saveBinaryFile(const snailLog& log, const std::string& path);
+
+} // namespace snailviewer.
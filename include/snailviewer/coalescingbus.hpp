@@ -0,0 +1,105 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/coalescingbus.hpp
+ * @author Haoran Luo
+ * @brief The event bus broadcasting events once per frame.
+ *
+ * Scrolling through a huge log raises hundreds of events telling the
+ * current footprint changes, while only the last one matters for the
+ * next redraw. So the events are held until the frame is drawn, and
+ * the coalescing events of the same uid collapse into the latest one.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/eventbus.hpp"
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The event bus holding events until they are flushed.
+ *
+ * The events could be raised on any thread, and they are broadcast in
+ * the order they are raised when the bus is flushed. When a coalescing
+ * event is raised while another of the same uid is pending, the pending
+ * one is discarded, so that the latest one is broadcast in its place
+ * in the order.
+ *
+ * The handlers must subscribe, unsubscribe and be flushed on the same
+ * thread, usually the thread of the user interface. The events raised
+ * by the handlers while flushing are broadcast on next flush.
+ *
+ * Destroying the bus discards the events pending.
+ */
+class coalescingEventBus : public eventBus {
+	/// The event waiting to be broadcast.
+	struct pendingEvent {
+		/// The uid of the event.
+		uid id;
+
+		/// The holder of the event, or null when it has been coalesced.
+		std::unique_ptr<eventHolder> holder;
+	};
+
+	/// The handlers of the events.
+	handlerTable handlers;
+
+	/// The mutex guarding the pending events.
+	std::mutex pendingMutex;
+
+	/// The events pending in the order they are raised.
+	std::vector<pendingEvent> pending;
+
+	/// The positions of the pending coalescing events. There are only a
+	/// few kinds of them, so they are searched linearly.
+	std::vector<size_t> coalesced;
+
+	/// The events being flushed, kept for reusing its capacity.
+	std::vector<pendingEvent> flushing;
+
+	virtual void subscribe(uid id, eventHandler<void*>& h) override;
+	virtual void unsubscribe(uid id, eventHandler<void*>& h) override;
+	virtual void broadcast(uid id, std::unique_ptr<eventHolder> evh) override;
+public:
+	/// Broadcast strongly typed events.
+	using eventBus::broadcast;
+
+	/// Broadcast the pending events, returning the number of events
+	/// broadcast. It is usually called once before drawing a frame.
+	size_t flush();
+
+	/// Retrieve the number of events pending, including the coalesced.
+	size_t backlog();
+
+	/// Retrieve the statistics of the bus, or null if not instrumented.
+	eventStatistics* statistics() const noexcept { return handlers.statistics(); }
+
+	/// Set the activator of the events, which should be done before the
+	/// bus is shared among threads.
+	void activateBy(eventActivator* activator) noexcept {
+		handlers.activateBy(activator);
+	}
+};
+
+} // namespace snailviewer.
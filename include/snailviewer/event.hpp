@@ -42,11 +42,51 @@
  * have their own eventType::id() method defined statically.
  */
 #include "snailviewer/uid.hpp"
+#include <cstddef>
 #include <memory>
 #include <type_traits>
 
 namespace snailviewer {
 
+/**
+ * @brief Detects whether the event opts into coalescing, by declaring
+ * "static constexpr bool coalescing = true".
+ */
+template<typename eventType, typename = void>
+struct eventCoalescing : std::false_type {};
+
+template<typename eventType> struct eventCoalescing<eventType,
+	typename std::enable_if<eventType::coalescing>::type> : std::true_type {};
+
+/**
+ * @brief The priority classes of the events, for the event buses
+ * scheduling the events, see also priorityEventBus.
+ */
+enum class eventPriority : unsigned char {
+	/// The events the user is waiting for, like keystrokes and redraws.
+	urgent = 0,
+
+	/// The events of no specified priority.
+	normal,
+
+	/// The events of background work, like progress and search hits,
+	/// which could be delayed and delivered in batches.
+	background,
+};
+
+/**
+ * @brief Detects the priority of the event, declared by "static
+ * constexpr eventPriority priority", or normal if not declared.
+ */
+template<typename eventType, typename = void>
+struct eventPriorityOf : std::integral_constant<
+	eventPriority, eventPriority::normal> {};
+
+template<typename eventType> struct eventPriorityOf<eventType,
+	typename std::enable_if<std::is_same<typename std::remove_cv<
+		decltype(eventType::priority)>::type, eventPriority>::value>::type>
+	: std::integral_constant<eventPriority, eventType::priority> {};
+
 /**
  * @brief Ensures that an event id is defined for some kind of event,
  * and wraps some convenient interfaces.
@@ -55,9 +95,43 @@ template<typename eventType> struct eventConcept {
 	static_assert(std::is_same<decltype(eventType::id()), uid>::value,
 		"The event must return an unique id identifying itselves.");
 	static uid id() noexcept { return eventType::id(); }
+
+	/// Whether only the latest of the events pending is worth broadcasting,
+	/// usually for the events reporting a state like the current footprint.
+	static constexpr bool coalescing() noexcept {
+		return eventCoalescing<eventType>::value;
+	}
+
+	/// The priority class of the event.
+	static constexpr eventPriority priority() noexcept {
+		return eventPriorityOf<eventType>::value;
+	}
 };
 
-template<typename> struct eventHandler;
+/**
+ * @brief The batch of events of the same type handled at once.
+ */
+template<typename eventType> class eventBatch {
+	/// The pointers to the events.
+	const void* const* events;
+
+	/// The number of events.
+	size_t count;
+public:
+	/// Construct the batch from the pointers to the events.
+	eventBatch(const void* const* events, size_t count):
+		events(events), count(count) {}
+
+	/// Retrieve the number of events.
+	size_t size() const noexcept { return count; }
+
+	/// Retrieve the event in the batch.
+	const eventType& operator[](size_t i) const {
+		return *reinterpret_cast<const eventType*>(events[i]);
+	}
+};
+
+template<typename> class eventHandler;
 
 /**
  * @brief Defines the event bus which manages the broadcasting of events.
@@ -70,18 +144,35 @@ class eventBus {
 	/// Only the event handler is permitted to invoke the subscribe
 	/// and unsubscribe method.
 	template<typename> friend class eventHandler;
-
+protected:
 	/**
 	 * Since the lifecycle and broadcasting timing of an fired event
 	 * is not defined for concrete type of event bus, we usually have
 	 * to copy out the fired event and hold it here.
+	 *
+	 * Events are raised at high frequency (scrolling, progress, etc.),
+	 * so the holders no larger than 64 bytes are allocated from a pool
+	 * of recycled slots instead of the global allocator.
 	 */
 	class eventHolder {
+	public:
 		/// The inheriting class defines how to destroying events.
-		virtual ~eventHolder() = 0;
+		virtual ~eventHolder() {}
 
 		/// The inheriting class provides pointer to event.
 		virtual const void* get() const = 0;
+
+		/// Whether the event held could be coalesced, see also eventConcept.
+		virtual bool coalescing() const noexcept = 0;
+
+		/// The priority class of the event held.
+		virtual eventPriority priority() const noexcept = 0;
+
+		/// Allocate the holder from the pool if it fits in a slot.
+		static void* operator new(size_t size);
+
+		/// Return the holder to the pool if it is from the pool.
+		static void operator delete(void* holder, size_t size) noexcept;
 	};
 
 	/**
@@ -122,23 +213,34 @@ public:
 	virtual ~eventBus() {}
 
 	/// Broadcast a strongly typed event via the event bus.
-	template<typename eventType> void broadcast(eventType&& event) {
+	template<typename eventRefType> void broadcast(eventRefType&& event) {
+		typedef typename std::decay<eventRefType>::type eventType;
 		struct typedEventHolder : public eventHolder {
 			/// The event that is held inside.
 			eventType event;
 
 			/// Constructor of the typed event holder.
-			typedEventHolder(eventType&& event):
-				event(std::forward(event)) {}
+			typedEventHolder(eventRefType&& event):
+				event(std::forward<eventRefType>(event)) {}
 
 			/// Destructor of the typed event holder.
 			virtual ~typedEventHolder() {}
 
 			/// Retrieve the concrete pointer to the event.
-			virtual const void* get() const { return &event; }
+			virtual const void* get() const override { return &event; }
+
+			/// Retrieve whether the event could be coalesced.
+			virtual bool coalescing() const noexcept override {
+				return eventConcept<eventType>::coalescing();
+			}
+
+			/// Retrieve the priority class of the event.
+			virtual eventPriority priority() const noexcept override {
+				return eventConcept<eventType>::priority();
+			}
 		};
-		broadcast(eventConcept<eventType>::id(), std::unique_ptr<typedEventHolder>(
-			new typedEventHolder(std::forward<eventType>(event))));
+		broadcast(eventConcept<eventType>::id(), std::unique_ptr<eventHolder>(
+			new typedEventHolder(std::forward<eventRefType>(event))));
 	}
 };
 
@@ -147,12 +249,19 @@ public:
  *
  * It just provides eye candies for invoking handle interfaces.
  */
-template<> struct eventHandler<void*> {
+template<> class eventHandler<void*> {
+public:
 	/// Provides the virtual destructor for an event handler.
 	virtual ~eventHandler() {}
 
 	/// Provides the pure virtual interface for broadcasting events.
 	virtual void handle(const void* evptr) = 0;
+
+	/// Provides the interface for broadcasting a batch of events of the
+	/// same type, which are handled one by one unless overridden.
+	virtual void handleBatch(const void* const* evptrs, size_t count) {
+		for(size_t i = 0; i < count; ++ i) handle(evptrs[i]);
+	}
 };
 
 /**
@@ -167,12 +276,12 @@ template<typename eventType> class eventHandler : public eventHandler<void*> {
 public:
 	/// Construct the event handler and register it self to the event bus.
 	eventHandler(eventBus& ebus): ebus(ebus) {
-		ebus.subscribe(eventConcept<eventType>::id(), this);
+		ebus.subscribe(eventConcept<eventType>::id(), *this);
 	}
 
 	/// Unsubscribe the event handler from the event bus.
 	virtual ~eventHandler() {
-		ebus.unsubscribe(eventConcept<eventType>::id(), this);
+		ebus.unsubscribe(eventConcept<eventType>::id(), *this);
 	}
 
 	/// The interface waiting to be implemented by the event handler.
@@ -182,6 +291,17 @@ public:
 	virtual void handle(const void* evptr) override {
 		handle(*reinterpret_cast<const eventType*>(evptr));
 	}
+
+	/// The interface handling a batch of events, which are handled one
+	/// by one unless overridden.
+	virtual void handleBatch(const eventBatch<eventType>& batch) {
+		for(size_t i = 0; i < batch.size(); ++ i) handle(batch[i]);
+	}
+
+	/// The interface implementing its parent interfaces.
+	virtual void handleBatch(const void* const* evptrs, size_t count) override {
+		handleBatch(eventBatch<eventType>(evptrs, count));
+	}
 };
 
 } // namespace snailviewer.
@@ -0,0 +1,195 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/eventbus.hpp
+ * @author Haoran Luo
+ * @brief The table of event handlers and the synchronous event bus.
+ *
+ * Every event bus needs to find the handlers of an event by its uid.
+ * The handler table is an open addressing table keyed by the uids,
+ * where each slot holds the contiguous handlers of the event, so that
+ * dispatching an event is a probe followed by a linear scan, with no
+ * allocation at all.
+ *
+ * The handler table is also where the event buses are instrumented,
+ * see also eventStatistics.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/eventstats.hpp"
+#include "snailviewer/uid.hpp"
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The hook activating the providers of the events, e.g. the
+ * modules declaring them, before the events are first dispatched.
+ */
+class eventActivator {
+public:
+	virtual ~eventActivator() {}
+
+	/// Activate the providers of the event, which may subscribe their
+	/// handlers to the bus dispatching it.
+	virtual void activate(uid id) = 0;
+};
+
+/**
+ * @brief The table mapping the event uids to their handlers.
+ *
+ * The handlers are invoked in the order they subscribe. The handlers
+ * may subscribe or unsubscribe while an event is being dispatched: the
+ * new handlers take effect on the next event, and the unsubscribed
+ * handlers are never invoked once unsubscribed.
+ *
+ * The table is not thread safe, the event buses using it are
+ * responsible for dispatching on appropriate threads.
+ *
+ * The table is instrumented when SNAIL_EVENT_STATS is set, and the
+ * report is appended to the file when the table is destroyed.
+ *
+ * When an activator is set, it is called on the first dispatch of each
+ * event, before the handlers of the event are looked up.
+ */
+class handlerTable {
+	/// The slot of the table.
+	struct slot {
+		/// The uid of the event, only meaningful when used.
+		uid id;
+
+		/// Whether the slot is used.
+		bool used;
+
+		/// Whether the event has been activated.
+		bool activated;
+
+		/// The handlers of the event, where the unsubscribed ones are
+		/// nulled while dispatching, and removed afterwards.
+		std::vector<eventHandler<void*>*> handlers;
+	};
+
+	/// The slots, whose number is a power of 2.
+	std::vector<slot> slots;
+
+	/// The number of used slots.
+	size_t used;
+
+	/// The number of times that the slots have been grown.
+	size_t generation;
+
+	/// The number of dispatches in progress.
+	size_t dispatching;
+
+	/// Whether there are nulled handlers to remove.
+	bool dirty;
+
+	/// The statistics of the events, or null if not instrumented.
+	std::unique_ptr<eventStatistics> stats;
+
+	/// The file to append the report to, or empty.
+	std::string reportPath;
+
+	/// The activator of the events, or null.
+	eventActivator* activator;
+
+	/// Find the slot of the uid, or the empty slot for it.
+	slot& probe(uid id);
+
+	/// Find the slot of the uid, using a slot for it if it is absent.
+	slot& insert(uid id);
+
+	/// Invoke the handlers of the event with the invoking function.
+	template<typename invokeType> void invoke(uid id, invokeType invoking);
+
+	/// Remove the nulled handlers after dispatching.
+	void compact();
+public:
+	/// Construct an empty handler table.
+	handlerTable();
+
+	/// Append the report to the file if instrumented by the environment.
+	~handlerTable();
+
+	/// Register the handler of the event.
+	void subscribe(uid id, eventHandler<void*>& handler);
+
+	/// Unregister the handler of the event, nothing happens if the
+	/// handler has not been registered.
+	void unsubscribe(uid id, eventHandler<void*>& handler);
+
+	/// Invoke the handlers of the event.
+	void dispatch(uid id, const void* event);
+
+	/// Invoke the handlers of the events of the same uid at once.
+	void dispatchBatch(uid id, const void* const* events, size_t count);
+
+	/// Retrieve the number of handlers of the event.
+	size_t count(uid id) const;
+
+	/// Enable the instrumentation, which should be done before the
+	/// table is shared among threads.
+	void instrument();
+
+	/// Retrieve the statistics, or null if not instrumented.
+	eventStatistics* statistics() const noexcept { return stats.get(); }
+
+	/// Set the activator of the events, which should be done before the
+	/// table is shared among threads.
+	void activateBy(eventActivator* value) noexcept { activator = value; }
+
+	/// Record the depth of the queue of the event bus if instrumented.
+	void sampleDepth(size_t depth) {
+		if(stats != nullptr) stats->queueDepth(depth);
+	}
+};
+
+/**
+ * @brief The event bus broadcasting events at the moment they are
+ * raised, on the thread raising them.
+ *
+ * The bus is meant to be used on a single thread, usually the thread
+ * of the user interface.
+ */
+class syncEventBus : public eventBus {
+	/// The handlers of the events.
+	handlerTable handlers;
+
+	virtual void subscribe(uid id, eventHandler<void*>& h) override;
+	virtual void unsubscribe(uid id, eventHandler<void*>& h) override;
+	virtual void broadcast(uid id, std::unique_ptr<eventHolder> evh) override;
+public:
+	/// Broadcast strongly typed events.
+	using eventBus::broadcast;
+
+	/// Retrieve the statistics of the bus, or null if not instrumented.
+	eventStatistics* statistics() const noexcept { return handlers.statistics(); }
+
+	/// Set the activator of the events, which should be done before the
+	/// bus is shared among threads.
+	void activateBy(eventActivator* activator) noexcept {
+		handlers.activateBy(activator);
+	}
+};
+
+} // namespace snailviewer.
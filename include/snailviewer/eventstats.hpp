@@ -0,0 +1,182 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/eventstats.hpp
+ * @author Haoran Luo
+ * @brief The optional instrumentation of the event buses.
+ *
+ * When scrolling becomes slow, we would like to know which handler is
+ * to blame. The instrumentation counts the broadcasts of each event,
+ * samples the depth of the queues, and records the latency of each
+ * handler in log-linear histograms, which have constant relative error
+ * and constant cost per record like the HDR histograms.
+ *
+ * The instrumentation is enabled for every event bus when the variable
+ * SNAIL_EVENT_STATS of the environment names a file, where the report
+ * is appended when the bus is destroyed.
+ */
+#include "snailviewer/uid.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace snailviewer {
+
+/// The variable of the environment naming the file to report to.
+constexpr const char* eventStatisticsVariable = "SNAIL_EVENT_STATS";
+
+/**
+ * @brief The log-linear histogram of non-negative values.
+ *
+ * The values below 2^subBits are counted exactly, and the others are
+ * counted into 2^subBits buckets per power of 2, so the relative error
+ * is at most 2^-subBits.
+ */
+class logHistogram {
+public:
+	/// The bits of the buckets per power of 2.
+	static constexpr unsigned subBits = 4;
+
+	/// The number of buckets.
+	static constexpr size_t bucketCount = (64 - subBits + 1) << subBits;
+private:
+	/// The counts of the buckets, allocated on first record.
+	std::vector<uint64_t> buckets;
+
+	/// The number of values recorded.
+	uint64_t total;
+
+	/// The sum of the values recorded.
+	uint64_t sum;
+
+	/// The maximum value recorded.
+	uint64_t maximum;
+public:
+	/// Construct the empty histogram.
+	logHistogram(): total(0), sum(0), maximum(0) {}
+
+	/// Record a value.
+	void record(uint64_t value);
+
+	/// Add the values recorded by another histogram.
+	void merge(const logHistogram& other);
+
+	/// Retrieve the number of values recorded.
+	uint64_t count() const noexcept { return total; }
+
+	/// Retrieve the mean of the values recorded.
+	double mean() const noexcept {
+		return total == 0? 0.0 : (double)sum / (double)total;
+	}
+
+	/// Retrieve the maximum value recorded.
+	uint64_t max() const noexcept { return maximum; }
+
+	/// Retrieve the value at the quantile in [0, 1], which is the upper
+	/// bound of the bucket it falls in.
+	uint64_t quantile(double q) const noexcept;
+
+	/// Retrieve the bucket of the value.
+	static size_t bucket(uint64_t value) noexcept;
+
+	/// Retrieve the largest value of the bucket.
+	static uint64_t upperBound(size_t bucket) noexcept;
+};
+
+/**
+ * @brief The statistics of an event bus.
+ *
+ * The statistics could be recorded and reported on any thread. Each
+ * thread records into its own shard, whose mutex is only contended
+ * while reporting, and the shards are merged into the report.
+ */
+class eventStatistics {
+	/// The statistics of an event.
+	struct eventRecord {
+		/// The number of broadcasts.
+		uint64_t broadcasts;
+
+		/// The latencies in nanoseconds of each type of handlers, which
+		/// are few for an event and scanned linearly.
+		std::vector<std::pair<std::type_index, logHistogram>> latencies;
+
+		/// Construct the empty record.
+		eventRecord(): broadcasts(0) {}
+	};
+
+	/// The statistics recorded by a thread.
+	struct shard {
+		/// The mutex guarding the shard against the reporter.
+		std::mutex mutex;
+
+		/// The statistics of the events.
+		std::unordered_map<uid, eventRecord> events;
+
+		/// The depths of the queue sampled on broadcasting.
+		logHistogram depths;
+	};
+
+	/// The serial number of the statistics, which tells them apart in
+	/// the shards cached by threads, since addresses could be reused.
+	const uint64_t serial;
+
+	/// The mutex guarding the shards.
+	mutable std::mutex shardMutex;
+
+	/// The shards of the threads recording.
+	std::map<std::thread::id, std::unique_ptr<shard>> shards;
+
+	/// Retrieve the shard of the calling thread.
+	shard& local();
+public:
+	/// Construct the empty statistics.
+	eventStatistics();
+
+	/// Record the broadcasts of the event.
+	void broadcast(uid id, uint64_t count = 1);
+
+	/// Record the depth of the queue.
+	void queueDepth(size_t depth);
+
+	/// Record the latency of the type of handler handling the event. The
+	/// type is taken before invoking, since the handler might be gone.
+	void handled(uid id, std::type_index handler, uint64_t nanos);
+
+	/// Render the report in text.
+	std::string report() const;
+
+	/**
+	 * @brief Append the report to the file.
+	 *
+	 * @throw std::system_error when the file cannot be written.
+	 */
+	void dump(const std::string& path) const;
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,182 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/footprinttree.hpp
+ * @author Haoran Luo
+ * @brief Precomputed index of the footprint tree.
+ *
+ * The footprints only know their parents, while navigating in the
+ * viewer requires their children, siblings and subtrees. The index is
+ * built once after loading so that these queries need no scanning:
+ * - The children of each footprint are kept in compressed sparse rows,
+ * with the roots being the children of a virtual root.
+ * - The footprints are numbered in pre-order, and the subtree of a
+ * footprint is the range [enter, leave) of pre-order numbers.
+ * - The depth of each footprint, where the roots are of depth 0.
+ */
+#include "snailviewer/table.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace snailviewer {
+
+struct footprintTable;
+
+/**
+ * @brief The index of the footprint tree.
+ *
+ * The columns are tables, so that they could either be built from the
+ * footprint table or borrowed from the binary snail log.
+ */
+class footprintTree {
+	/// The offsets of the children of each footprint, followed by the
+	/// offsets of the roots, and a sentinel at the end.
+	table<uint32_t> childOffset;
+
+	/// The children of the footprints, in ascending order per parent.
+	table<uint32_t> childList;
+
+	/// The depth of each footprint.
+	table<uint32_t> depthColumn;
+
+	/// The pre-order number of each footprint.
+	table<uint32_t> enterColumn;
+
+	/// The pre-order number right past the subtree of each footprint.
+	table<uint32_t> leaveColumn;
+
+	/// The footprint of each pre-order number.
+	table<uint32_t> orderColumn;
+
+	/// Build the index when the parents precede their children.
+	void buildOrdered(const footprintTable& footprints);
+
+	/// Build the index by traversing the children.
+	void buildTraversal(const footprintTable& footprints);
+public:
+	/**
+	 * @brief Build the index from the footprint table.
+	 *
+	 * The index is built in linear time. It is done in a single sweep
+	 * when every parent precedes its children, which is the case for
+	 * logs written by the tracer, or by a depth first traversal else.
+	 *
+	 * @throw std::invalid_argument when the parents form a cycle, or
+	 * some parent is out of range.
+	 */
+	void build(const footprintTable& footprints);
+
+	/// Retrieve the number of footprints indexed.
+	size_t size() const noexcept { return depthColumn.size(); }
+
+	/// Retrieve the first child of the footprint, or of the virtual
+	/// root when the index is absent.
+	const uint32_t* childBegin(uint32_t i) const noexcept {
+		return childList.data() + childOffset[slot(i)];
+	}
+
+	/// Retrieve the end of the children of the footprint.
+	const uint32_t* childEnd(uint32_t i) const noexcept {
+		return childList.data() + childOffset[slot(i) + 1];
+	}
+
+	/// Retrieve the number of children of the footprint.
+	size_t childCount(uint32_t i) const noexcept {
+		return childOffset[slot(i) + 1] - childOffset[slot(i)];
+	}
+
+	/// Retrieve the depth of the footprint.
+	uint32_t depth(uint32_t i) const { return depthColumn[i]; }
+
+	/// Retrieve the pre-order number of the footprint.
+	uint32_t preorder(uint32_t i) const { return enterColumn[i]; }
+
+	/// Retrieve the post-order number of the footprint.
+	uint32_t postorder(uint32_t i) const {
+		return leaveColumn[i] - 1 - depthColumn[i];
+	}
+
+	/// Retrieve the footprint by its pre-order number.
+	uint32_t atPreorder(uint32_t n) const { return orderColumn[n]; }
+
+	/// Retrieve the number of footprints in the subtree, including itself.
+	uint32_t subtreeSize(uint32_t i) const {
+		return leaveColumn[i] - enterColumn[i];
+	}
+
+	/// Whether the ancestor is an ancestor of (or is) the descendant.
+	bool isAncestor(uint32_t ancestor, uint32_t descendant) const {
+		return enterColumn[ancestor] <= enterColumn[descendant] &&
+			enterColumn[descendant] < leaveColumn[ancestor];
+	}
+
+	/// Retrieve the next sibling of the footprint, or absent.
+	uint32_t nextSibling(uint32_t i) const;
+
+	/// Retrieve the previous sibling of the footprint given its parent,
+	/// or absent. The sibling is found by binary search.
+	uint32_t previousSibling(uint32_t i, uint32_t parent) const;
+
+	/// Retrieve the first footprint after the subtree in pre-order,
+	/// that is stepping over the calls made by the footprint.
+	uint32_t stepOver(uint32_t i) const;
+
+	/// Retrieve the first footprint after the subtree of the parent in
+	/// pre-order, that is stepping out of the current call.
+	uint32_t stepOut(uint32_t parent) const;
+
+	/// Retrieve the underlying columns, for writing binary snail logs.
+	const table<uint32_t>& childOffsets() const noexcept { return childOffset; }
+	const table<uint32_t>& children() const noexcept { return childList; }
+	const table<uint32_t>& depths() const noexcept { return depthColumn; }
+	const table<uint32_t>& enters() const noexcept { return enterColumn; }
+	const table<uint32_t>& leaves() const noexcept { return leaveColumn; }
+	const table<uint32_t>& orders() const noexcept { return orderColumn; }
+
+	/**
+	 * @brief Validate the columns against the footprint table in linear
+	 * time, which is for the columns borrowed from elsewhere.
+	 *
+	 * @throw std::invalid_argument when the columns are not the index
+	 * that would be built from the footprint table.
+	 */
+	void validate(const footprintTable& footprints) const;
+
+	/// Borrow the columns from elsewhere, which must be validated.
+	void borrow(size_t count, const uint32_t* offsets, const uint32_t* list,
+			const uint32_t* depths, const uint32_t* enters,
+			const uint32_t* leaves, const uint32_t* orders) {
+		childOffset.borrow(offsets, count + 2);
+		childList.borrow(list, count);
+		depthColumn.borrow(depths, count);
+		enterColumn.borrow(enters, count);
+		leaveColumn.borrow(leaves, count);
+		orderColumn.borrow(orders, count);
+	}
+private:
+	/// Map the footprint index to the slot in the offsets, where the
+	/// absent index maps to the virtual root.
+	size_t slot(uint32_t i) const noexcept {
+		return i == 0xffffffffu? size() : (size_t)i;
+	}
+};
+
+} // namespace snailviewer.
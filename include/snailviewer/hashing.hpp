@@ -0,0 +1,73 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/hashing.hpp
+ * @author Haoran Luo
+ * @brief Hashing of byte strings for the in-memory hash tables.
+ *
+ * The hash tables of the snail log are keyed by 32-bit hashes, which
+ * are folded from the 64-bit hashes computed over the keys.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace snailviewer {
+
+/// Mix the 64-bit value into the hash.
+inline uint64_t hashMix(uint64_t hash, uint64_t value) noexcept {
+	hash ^= value + 0x9e3779b97f4a7c15ull + (hash << 6) + (hash >> 2);
+	hash *= 0xff51afd7ed558ccdull;
+	return hash ^ (hash >> 32);
+}
+
+/// Mix the bytes into the hash, consuming 8 bytes at a time.
+inline uint64_t hashBytes(uint64_t hash, const char* data, size_t length) noexcept {
+	size_t i = 0;
+	for(; i + 8 <= length; i += 8) {
+		uint64_t word;
+		std::memcpy(&word, data + i, 8);
+		hash = hashMix(hash, word);
+	}
+	uint64_t tail = 0;
+	if(i < length) std::memcpy(&tail, data + i, length - i);
+	return hashMix(hash, tail ^ ((uint64_t)length << 56));
+}
+
+/// Multiply the values into 128-bit and fold the product, which is the
+/// mixing function of wyhash.
+inline uint64_t hashMultiply(uint64_t a, uint64_t b) noexcept {
+	unsigned __int128 product = (unsigned __int128)a * b;
+	return (uint64_t)product ^ (uint64_t)(product >> 64);
+}
+
+/// Hash the 128-bit value by keying its halves with the secrets of
+/// wyhash and multiplying them, so that every byte affects the hash.
+inline uint64_t hashWide(uint64_t low, uint64_t high) noexcept {
+	return hashMultiply(low ^ 0xa0761d6478bd642full, high ^ 0xe7037ed1a0b428dbull);
+}
+
+/// Fold the hash into 32-bit.
+inline uint32_t hashFold(uint64_t hash) noexcept {
+	return (uint32_t)(hash ^ (hash >> 32));
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,180 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/jsonsax.hpp
+ * @author Haoran Luo
+ * @brief Event driven (SAX-style) JSON parser definitions.
+ *
+ * A snail log could be several gigabytes in size, so building a DOM
+ * of the whole document is not affordable. The parser here walks over
+ * the text once and reports what it sees to a handler, and the handler
+ * builds whatever compact structure it desires.
+ *
+ * The parser works on a contiguous range of characters (usually a
+ * mapped file), so the handler is given pointers into the original
+ * text instead of copies whenever possible.
+ */
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The type of the scalar values reported by the parser.
+ */
+enum class jsonType : char {
+	/// The value is a string, the reported range includes the quotes.
+	string = 0,
+
+	/// The value is a number.
+	number,
+
+	/// The value is either true or false.
+	boolean,
+
+	/// The value is null.
+	null,
+};
+
+/**
+ * @brief How should the parser proceed after a compound (object or
+ * array) value is encountered.
+ */
+enum class jsonAction : char {
+	/// Report the members of the compound value to the handler.
+	descend = 0,
+
+	/// Skip the compound value as a whole, the handler will receive
+	/// the end notification of the compound value immediately.
+	skip,
+};
+
+/**
+ * @brief The error raised when the text is not a well-formed JSON.
+ */
+class jsonError : public std::runtime_error {
+	/// The offset from the beginning of the text where error occurs.
+	size_t errorOffset;
+public:
+	/// Construct the error with message and offset.
+	jsonError(const std::string& message, size_t offset);
+
+	/// Retrieve the offset where the error occurs.
+	size_t offset() const noexcept { return errorOffset; }
+};
+
+/**
+ * @brief Defines the handler receiving parsing events.
+ *
+ * The pointers passed to the handler are pointing into the parsed text
+ * (except for the decoded keys with escape sequences), so they remain
+ * valid as long as the text does.
+ */
+struct jsonHandler {
+	/// Provides the virtual destructor for the handler.
+	virtual ~jsonHandler() {}
+
+	/// An object value begins at the specified position.
+	virtual jsonAction beginObject(const char* at) = 0;
+
+	/// An object value ends, the pointer is right past the '}'.
+	virtual void endObject(const char* past) = 0;
+
+	/// An array value begins at the specified position.
+	virtual jsonAction beginArray(const char* at) = 0;
+
+	/// An array value ends, the pointer is right past the ']'.
+	virtual void endArray(const char* past) = 0;
+
+	/// The decoded key of the next member inside an object.
+	virtual void key(const char* name, size_t length) = 0;
+
+	/// A scalar value with its raw text range [begin, end).
+	virtual void scalar(jsonType type, const char* begin, const char* end) = 0;
+
+	/// Skip the compound value at the specified position, which the
+	/// handler has chosen to skip, returning the pointer right past it.
+	/// The value is scanned through by jsonSkip by default, while the
+	/// handler could consume the value by itself instead.
+	virtual const char* skip(const char* at,
+		const char* origin, const char* end);
+};
+
+/**
+ * @brief The parser that drives the handler.
+ *
+ * The parser does not recurse on nested values, so a deeply nested
+ * captured object will never exhaust the stack.
+ */
+class jsonParser {
+	/// The stack of opened compound values ('{' or '[').
+	std::vector<char> nesting;
+
+	/// The scratch buffer for decoding escaped keys.
+	std::string scratch;
+public:
+	/**
+	 * @brief Parse a complete JSON value inside the text range.
+	 *
+	 * Only whitespaces are permitted after the parsed value.
+	 *
+	 * @param[in] begin the beginning of the text.
+	 * @param[in] end the end of the text.
+	 * @param[in] handler the handler receiving events.
+	 * @param[in] origin the beginning of the whole text when parsing a
+	 * part of it, which the error offsets are relative to, or null.
+	 * @throw jsonError when the text is malformed.
+	 */
+	void parse(const char* begin, const char* end,
+		jsonHandler& handler, const char* origin = nullptr);
+};
+
+/**
+ * @brief Find the end of the JSON value starting at the position.
+ *
+ * The value is not validated strictly, but only scanned through with
+ * strings and nesting respected. It is used for skipping values.
+ *
+ * @return the pointer right past the value.
+ * @throw jsonError when the value is truncated.
+ */
+const char* jsonSkip(const char* at, const char* begin, const char* end);
+
+/**
+ * @brief Decode the raw string token (including quotes) into UTF-8.
+ *
+ * @param[in] begin the beginning of the token, pointing at '"'.
+ * @param[in] end the end of the token, pointing right past '"'.
+ * @param[out] out the decoded string.
+ */
+void jsonUnescape(const char* begin, const char* end, std::string& out);
+
+/**
+ * @brief Parse the raw number token as an unsigned 32-bit integer.
+ *
+ * @return whether the token is a non-negative integer in range.
+ */
+bool jsonToUint32(const char* begin, const char* end, uint32_t& out) noexcept;
+
+} // namespace snailviewer.
@@ -0,0 +1,94 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/jsonscan.hpp
+ * @author Haoran Luo
+ * @brief Vectorized scanner of the structure of JSON text.
+ *
+ * Skipping values and locating the entries of the footprints array
+ * only need the brackets and commas outside strings. The scanner finds
+ * them 64 bytes at a time: the characters of interest are classified
+ * into bitmasks with SIMD instructions, then the escaped quotes and the
+ * bytes inside strings are masked out with bit manipulation, in the
+ * spirit of the first stage of simdjson.
+ *
+ * The classifier is chosen at runtime: AVX2 or SSE on x86 processors
+ * supporting them, otherwise a portable scalar one.
+ */
+#include <cstddef>
+#include <cstdint>
+
+namespace snailviewer {
+
+/**
+ * @brief The structural characters of a block of 64 bytes.
+ *
+ * The i-th bit of the masks refers to the i-th byte of the block, and
+ * only the characters outside strings are reported.
+ */
+struct jsonBlock {
+	/// The beginning of the block.
+	const char* begin;
+
+	/// The opening brackets '{' and '['.
+	uint64_t opens;
+
+	/// The closing brackets '}' and ']'.
+	uint64_t closes;
+
+	/// The commas.
+	uint64_t commas;
+};
+
+/**
+ * @brief The scanner walking through the text block by block.
+ *
+ * The scanning must begin outside strings. The bytes of the last block
+ * that are past the end of the text are treated as whitespaces.
+ */
+class jsonScanner {
+	/// The beginning of the next block.
+	const char* position;
+
+	/// The end of the text.
+	const char* end;
+
+	/// Whether the first byte of the next block is escaped.
+	uint64_t escapedCarry;
+
+	/// All ones if the next block begins inside a string.
+	uint64_t stringCarry;
+public:
+	/// Construct the scanner of the text.
+	jsonScanner(const char* begin, const char* end): position(begin),
+		end(end), escapedCarry(0), stringCarry(0) {}
+
+	/// Scan the next block, returning false when the text is exhausted.
+	bool next(jsonBlock& block);
+
+	/// Whether the scanned text ends inside a string.
+	bool insideString() const noexcept { return stringCarry != 0; }
+};
+
+/// Retrieve the name of the classifier chosen at runtime.
+const char* jsonScanLevel() noexcept;
+
+} // namespace snailviewer.
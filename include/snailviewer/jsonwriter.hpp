@@ -0,0 +1,77 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/jsonwriter.hpp
+ * @author Haoran Luo
+ * @brief Writing the loaded snail log back into JSON text.
+ *
+ * The writer renders pieces of the root entity independently, so that
+ * the pieces could be rendered on different threads and concatenated
+ * in order afterwards.
+ */
+#include "snailviewer/snaillog.hpp"
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief Append the JSON string literal of the text to the output.
+ */
+void jsonQuote(const char* data, size_t length, std::string& out);
+
+/**
+ * @brief The writer rendering a loaded snail log as JSON text.
+ *
+ * Objects that are the entries of the root "objects" array are written
+ * as references to them, the others are written as object entities.
+ */
+class jsonWriter {
+	/// The log being written.
+	const snailLog& log;
+
+	/// The map from object ids to root objects indices, or absent.
+	std::vector<uint32_t> rootIndex;
+
+	/// Render the object, given whether it should be referred.
+	void object(uint32_t id, bool allowReference, std::string& out) const;
+public:
+	/// Construct the writer of the log.
+	explicit jsonWriter(const snailLog& log);
+
+	/// Render the text from the beginning of the root entity to the
+	/// opening of the "objects" array.
+	void prologue(std::string& out) const;
+
+	/// Render the text between the "objects" and "footprints" array.
+	void interlude(std::string& out) const;
+
+	/// Render the text after the "footprints" array.
+	void epilogue(std::string& out) const;
+
+	/// Render the entries of root objects in [begin, end).
+	void rootObjects(size_t begin, size_t end, std::string& out) const;
+
+	/// Render the footprints in [begin, end).
+	void footprints(size_t begin, size_t end, std::string& out) const;
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,182 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/loader.hpp
+ * @author Haoran Luo
+ * @brief Loading snail logs into the in-memory tables.
+ *
+ * The loader drives the event driven JSON parser over the snail log
+ * and fills the tables while parsing, so there's never a DOM of the
+ * whole document. The peak memory is the size of the tables plus the
+ * nesting of the deepest object.
+ *
+ * The footprints and struct fields may refer to the entries of the
+ * root "objects" array by their indices, or embed the object entities
+ * directly. Both forms are accepted.
+ *
+ * Most footprints are never expanded in the viewer, so the objects of
+ * footprints could be loaded lazily: the loader skips them and records
+ * their text ranges, and they are decoded by decodeObjects on demand.
+ * The malformed objects are then reported when they are decoded.
+ *
+ * The "footprints" array is the bulk of a snail log, and its entries
+ * are independent of each other. It must be the last member of the
+ * log, so that it is loaded as soon as it is found: its entries are
+ * located by scanning through and grouped into chunks, which are parsed
+ * on a thread pool into separate tables and appended to the log in
+ * order, while the later chunks are still being located.
+ *
+ * The loading could be observed for showing the footprints before the
+ * whole log is loaded. The footprint tables are reserved for the most
+ * footprints the text could hold and never moved afterwards, so the
+ * footprints loaded could be read while the later ones are appended.
+ */
+#include "snailviewer/snaillog.hpp"
+#include "snailviewer/jsonsax.hpp"
+#include <string>
+
+namespace snailviewer {
+
+/// The number of footprints to load when it is unknown until they are
+/// loaded, which is the case for JSON snail logs.
+constexpr size_t unknownFootprints = size_t(-1);
+
+/**
+ * @brief The observer notified while loading.
+ *
+ * The observer is notified on the thread loading the log. Once the log
+ * is opened, the tables other than the footprints, the bindings and the
+ * objects are complete. When loading with lazy objects, the objects are
+ * complete as well, and decodeObjects could be called for the loaded
+ * footprints. The footprint tree is built only after loading.
+ *
+ * Throwing from the observer aborts the loading.
+ */
+class loadObserver {
+public:
+	virtual ~loadObserver() {}
+
+	/// The log is opened, with the number of footprints to load or
+	/// unknownFootprints, and whether their objects are decoded lazily.
+	/// Binary logs are never lazy, whatever the options are.
+	virtual void opened(const snailLog& log, size_t footprints, bool lazy) = 0;
+
+	/// The footprints [begin, end) are loaded, after the ones before.
+	virtual void loaded(const snailLog& log, uint32_t begin, uint32_t end) = 0;
+};
+
+/**
+ * @brief The consumer taking the bindings of the loaded footprints.
+ *
+ * The bindings are the bulk of the eagerly loaded objects. When they
+ * are only to be written out, they could be consumed while loading
+ * instead of being kept in the log, so that they never pile up.
+ */
+class bindingConsumer {
+public:
+	virtual ~bindingConsumer() {}
+
+	/// Consume the bindings following the ones consumed before, whose
+	/// objects are in the objects of the log.
+	virtual void consume(const objectBinding* bindings, size_t count) = 0;
+};
+
+/**
+ * @brief The options of loading JSON snail logs.
+ */
+struct loadOptions {
+	/// Whether the objects of footprints are decoded on demand.
+	bool lazyObjects;
+
+	/// The number of threads parsing footprints, or 0 for the number
+	/// of hardware threads.
+	size_t threads;
+
+	/// The observer of the loading, or null.
+	loadObserver* observer;
+
+	/// The consumer of the bindings of footprints, or null for keeping
+	/// them in the log, which is used only when the objects are loaded
+	/// eagerly. The bindings of the log are left empty when they are
+	/// consumed, while the footprints still refer to them by the order
+	/// of consuming.
+	bindingConsumer* bindings;
+
+	/// Construct the options of loading everything eagerly on all
+	/// hardware threads.
+	loadOptions(): lazyObjects(false), threads(0), observer(nullptr),
+		bindings(nullptr) {}
+};
+
+/**
+ * @brief Load the snail log from its JSON text.
+ *
+ * When loading with lazy objects, the text must live as long as the log.
+ *
+ * @param[in] begin the beginning of the text.
+ * @param[in] end the end of the text.
+ * @param[out] log the log to fill, which should be empty.
+ * @param[in] options the options of loading.
+ * @throw jsonError when the text is malformed or inconsistent.
+ */
+void loadJson(const char* begin, const char* end, snailLog& log,
+	const loadOptions& options = loadOptions());
+
+/**
+ * @brief Load the snail log from a JSON file.
+ *
+ * The file is mapped into memory during loading and unmapped after,
+ * unless the objects are loaded lazily, where the mapping is kept
+ * inside the log.
+ *
+ * @throw jsonError when the text is malformed or inconsistent.
+ * @throw std::system_error when the file cannot be read.
+ */
+void loadJsonFile(const std::string& path, snailLog& log,
+	const loadOptions& options = loadOptions());
+
+/**
+ * @brief Load the snail log file of either JSON or binary format.
+ *
+ * The binary snail log is recognized by its magic number, and its
+ * mapping is kept inside the log. Otherwise it is loaded as JSON.
+ *
+ * @throw jsonError when the JSON text is malformed or inconsistent.
+ * @throw formatError when the binary snail log is malformed.
+ * @throw std::system_error when the file cannot be read.
+ */
+void loadFile(const std::string& path, snailLog& log,
+	const loadOptions& options = loadOptions());
+
+/**
+ * @brief Decode the objects of a footprint of the lazily loaded log.
+ *
+ * @param[in] log the log loaded with lazy objects.
+ * @param[in] footprint the index of the footprint.
+ * @param[out] decoded the decoded objects, which should be empty.
+ * @throw jsonError when the objects are malformed, where the offset is
+ * relative to the beginning of the objects of the footprint, or when
+ * the objects of the footprint are not loaded lazily.
+ */
+void decodeObjects(const snailLog& log, uint32_t footprint,
+	decodedObjects& decoded);
+
+} // namespace snailviewer.
@@ -0,0 +1,96 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/mapping.hpp
+ * @author Haoran Luo
+ * @brief Read-only memory mapped files and anonymous mapped pages.
+ *
+ * Snail logs are mapped into the address space rather than read into
+ * buffers, so that the pages are backed by the page cache and could be
+ * evicted by the kernel under memory pressure.
+ *
+ * The tables reserved far beyond their need are backed by anonymous
+ * pages mapped without reserving swap space, which are committed only
+ * once they are touched.
+ */
+#include <cstddef>
+#include <string>
+
+namespace snailviewer {
+
+/**
+ * @brief The read-only mapping of a whole file.
+ *
+ * The mapping is movable but not copyable. An empty file is presented
+ * as an empty range with non-null data pointer.
+ */
+class mappedFile {
+	/// The beginning of the mapped region.
+	const char* region;
+
+	/// The size of the mapped region.
+	size_t length;
+public:
+	/// Construct an empty mapping.
+	mappedFile() noexcept;
+
+	/**
+	 * @brief Map the specified file into memory.
+	 *
+	 * @param[in] path the path to the file.
+	 * @throw std::system_error when the file could not be mapped.
+	 */
+	explicit mappedFile(const std::string& path);
+
+	/// Move the mapping from another instance.
+	mappedFile(mappedFile&& other) noexcept;
+
+	/// Move assign the mapping from another instance.
+	mappedFile& operator=(mappedFile&& other) noexcept;
+
+	/// Unmap the file.
+	~mappedFile();
+
+	// The mapping is not copyable.
+	mappedFile(const mappedFile&) = delete;
+	mappedFile& operator=(const mappedFile&) = delete;
+
+	/// Retrieve the beginning of the mapped content.
+	const char* data() const noexcept { return region; }
+
+	/// Retrieve the size of the mapped content.
+	size_t size() const noexcept { return length; }
+
+	/// Retrieve the end of the mapped content.
+	const char* end() const noexcept { return region + length; }
+};
+
+/**
+ * @brief Map the anonymous pages without reserving swap space.
+ *
+ * @throw std::bad_alloc when the pages cannot be mapped.
+ */
+void* mapPages(size_t size);
+
+/// Unmap the pages mapped by mapPages.
+void unmapPages(void* pages, size_t size) noexcept;
+
+} // namespace snailviewer.
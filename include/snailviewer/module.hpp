@@ -0,0 +1,130 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/module.hpp
+ * @author Haoran Luo
+ * @brief The interface between the viewer and its loadable modules.
+ *
+ * A loadable module is a shared object exporting the entry function
+ * named by moduleEntrySymbol, which returns the static descriptor of
+ * the module. The descriptor declares the uids of the components
+ * (events, widgets, key bindings and colors) the module provides, so
+ * that the viewer indexes them without initializing the module. Since
+ * loading the shared object runs its static constructors and the entry
+ * function, they should do nothing more than providing the descriptor.
+ * The module is initialized only when one of its components is used.
+ *
+ * A module is usually defined as:
+ *
+ *   static const moduleComponent components[] = {
+ *       { makeUid(uidType::widget, "HELLO", "FML", "GREETER"), "greeter" },
+ *   };
+ *   static const moduleDescriptor descriptor = {
+ *       moduleAbiVersion, makeUid(uidType::module, "HELLO", "FML", ""),
+ *       components, 1, initialize, finalize, resolve };
+ *   SNAIL_MODULE(descriptor)
+ *
+ * Since the modules are built against the headers of the viewer, the
+ * descriptor is bound to the ABI version of the viewer.
+ */
+#include "snailviewer/uid.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace snailviewer {
+
+class eventBus;
+class widget;
+
+/// The version of the module interface, which is incremented whenever
+/// the descriptor or the context changes.
+constexpr uint32_t moduleAbiVersion = 1;
+
+/// The name of the entry function exported by the modules.
+constexpr const char* moduleEntrySymbol = "snailModuleDescriptor";
+
+/**
+ * @brief The facilities of the viewer provided to the modules.
+ */
+struct moduleContext {
+	/// The event bus of the viewer.
+	eventBus* bus;
+};
+
+/**
+ * @brief The component declared by a module.
+ */
+struct moduleComponent {
+	/// The uid of the component, which must not be of module type.
+	uid id;
+
+	/// The readable name of the component.
+	const char* name;
+};
+
+/**
+ * @brief The implementation of a widget component, which is resolved
+ * as a pointer to it. The event components resolve to nothing, since
+ * the module initialized subscribes the handlers of its events.
+ */
+struct widgetComponent {
+	/// Create the widget, which is owned by the viewer afterwards.
+	widget* (*create)(const moduleContext& context);
+};
+
+/**
+ * @brief The static descriptor of a module.
+ */
+struct moduleDescriptor {
+	/// The version of the interface, which must be moduleAbiVersion.
+	uint32_t abiVersion;
+
+	/// The uid of the module, which must be of module type.
+	uid id;
+
+	/// The components declared by the module.
+	const moduleComponent* components;
+
+	/// The number of components.
+	size_t componentCount;
+
+	/// Initialize the module on first use, returning whether it has
+	/// succeeded. It could be null if nothing is to be initialized.
+	bool (*initialize)(const moduleContext& context);
+
+	/// Finalize the initialized module. It could be null.
+	void (*finalize)();
+
+	/// Retrieve the implementation of the component after the module
+	/// is initialized, whose type is defined by the component type.
+	const void* (*resolve)(uid id);
+};
+
+/// The type of the entry function of the modules.
+typedef const moduleDescriptor* (*moduleEntry)();
+
+} // namespace snailviewer.
+
+/// Export the descriptor as the entry of the module.
+#define SNAIL_MODULE(descriptor) extern "C" \
+	const snailviewer::moduleDescriptor* snailModuleDescriptor() { \
+		return &(descriptor); \
+	}
@@ -0,0 +1,135 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/mpscqueue.hpp
+ * @author Haoran Luo
+ * @brief Bounded lock-free queue of multiple producers and one consumer.
+ *
+ * The queue is a ring of cells, each stamped with a sequence number
+ * telling whether it is ready to be written or read in the current lap
+ * (the bounded queue of Dmitry Vyukov). The producers claim cells by
+ * advancing the shared enqueue position with compare-and-swap, while
+ * the only consumer owns the dequeue position.
+ */
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+namespace snailviewer {
+
+/**
+ * @brief The bounded lock-free queue of multiple producers and a single
+ * consumer.
+ *
+ * The values must be trivially copyable, so that they could be left in
+ * the cells without being destroyed.
+ */
+template<typename valueType> class mpscQueue {
+	static_assert(std::is_trivially_copyable<valueType>::value,
+		"The values of the queue must be trivially copyable.");
+
+	/// The cell of the ring.
+	struct cell {
+		/// The sequence number of the cell, which equals the position
+		/// when it is ready to be written, or the position plus one
+		/// when it is ready to be read.
+		std::atomic<size_t> sequence;
+
+		/// The value stored in the cell.
+		valueType value;
+	};
+
+	/// The cells of the ring, whose number is a power of 2.
+	std::unique_ptr<cell[]> cells;
+
+	/// The mask of the positions into cells.
+	size_t mask;
+
+	/// The position to enqueue, shared by the producers.
+	alignas(64) std::atomic<size_t> enqueuePosition;
+
+	/// The position to dequeue, only written by the consumer.
+	alignas(64) std::atomic<size_t> dequeuePosition;
+public:
+	/// Construct the queue of the capacity, which must be a power of 2.
+	explicit mpscQueue(size_t capacity): cells(new cell[capacity]),
+		mask(capacity - 1), enqueuePosition(0), dequeuePosition(0) {
+		if(capacity < 2 || (capacity & mask) != 0)
+			throw std::invalid_argument("The capacity must be a power of 2.");
+		for(size_t i = 0; i < capacity; ++ i)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	/// Retrieve the capacity of the queue.
+	size_t capacity() const noexcept { return mask + 1; }
+
+	/// Enqueue the value, returning false if the queue is full. It
+	/// could be called from any thread.
+	bool push(const valueType& value) noexcept {
+		size_t position = enqueuePosition.load(std::memory_order_relaxed);
+		cell* target;
+		while(true) {
+			target = &cells[position & mask];
+			size_t sequence = target->sequence.load(std::memory_order_acquire);
+			intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+			if(difference == 0) {
+				if(enqueuePosition.compare_exchange_weak(position,
+					position + 1, std::memory_order_relaxed)) break;
+			} else if(difference < 0) return false;
+			else position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+		target->value = value;
+		target->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// Dequeue a value, returning false if the queue is empty. It must
+	/// only be called from the consumer thread.
+	bool pop(valueType& value) noexcept {
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		cell& target = cells[position & mask];
+		size_t sequence = target.sequence.load(std::memory_order_acquire);
+		if(sequence != position + 1) return false;
+		value = target.value;
+		target.sequence.store(position + mask + 1, std::memory_order_release);
+		dequeuePosition.store(position + 1, std::memory_order_relaxed);
+		return true;
+	}
+
+	/// Whether the queue is empty, only exact for the consumer.
+	bool empty() const noexcept {
+		size_t position = dequeuePosition.load(std::memory_order_relaxed);
+		return cells[position & mask].sequence.load(
+			std::memory_order_acquire) != position + 1;
+	}
+
+	/// Retrieve the approximate number of values in the queue.
+	size_t size() const noexcept {
+		size_t enqueued = enqueuePosition.load(std::memory_order_relaxed);
+		size_t dequeued = dequeuePosition.load(std::memory_order_relaxed);
+		return enqueued > dequeued? enqueued - dequeued : 0;
+	}
+};
+
+} // namespace snailviewer.
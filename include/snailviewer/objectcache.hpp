@@ -0,0 +1,116 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/objectcache.hpp
+ * @author Haoran Luo
+ * @brief The cache of the objects of footprints decoded on demand.
+ *
+ * When the log is loaded with lazy objects, the objects of a footprint
+ * are decoded when the footprint is focused. The decoded footprints
+ * are kept in least recently used order, and the least recently used
+ * ones are released when the memory they occupy exceeds the budget.
+ */
+#include "snailviewer/snaillog.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace snailviewer {
+
+/**
+ * @brief The cache of decoded objects of a lazily loaded log.
+ *
+ * The decoded objects are shared with the callers, so releasing them
+ * from the cache never invalidates the ones being viewed. The cache
+ * could be used from multiple threads.
+ */
+class objectCache {
+	/// The log to decode from.
+	const snailLog& log;
+
+	/// The entry of the cache.
+	typedef std::pair<uint32_t, std::shared_ptr<const decodedObjects>> entry;
+
+	/// The decoded footprints, the most recently used first.
+	std::list<entry> recent;
+
+	/// The map from footprints to their entries.
+	std::unordered_map<uint32_t, std::list<entry>::iterator> entries;
+
+	/// The memory budget in bytes.
+	size_t budget;
+
+	/// The memory occupied by the decoded footprints in bytes.
+	size_t usage;
+
+	/// Whether the log is loaded with lazy objects.
+	bool lazy;
+
+	/// The mutex guarding the cache.
+	mutable std::mutex mutex;
+
+	/// Release the least recently used ones until within the budget,
+	/// while keeping the most recently used one.
+	void evict();
+public:
+	/// The default memory budget, which is 64MiB.
+	static constexpr size_t defaultBudget = size_t(64) << 20;
+
+	/// Construct the cache of the log given the memory budget.
+	explicit objectCache(const snailLog& log,
+		size_t budget = defaultBudget);
+
+	/**
+	 * @brief Retrieve the decoded objects of the footprint.
+	 *
+	 * The objects are decoded if they are not in the cache. For logs
+	 * loaded eagerly, there's nothing to decode and the result is the
+	 * shared empty objects, which is never cached, see also setLazy.
+	 *
+	 * @throw jsonError when the objects are malformed.
+	 */
+	std::shared_ptr<const decodedObjects> get(uint32_t footprint);
+
+	/// Tell whether the log is loaded with lazy objects, once it is
+	/// opened, e.g. from logOpenedEvent. The log is assumed eager before.
+	void setLazy(bool lazyObjects);
+
+	/// Whether the log is told to be loaded with lazy objects.
+	bool isLazy() const;
+
+	/// Change the memory budget, releasing the exceeding ones.
+	void setBudget(size_t bytes);
+
+	/// Retrieve the memory budget in bytes.
+	size_t memoryBudget() const;
+
+	/// Retrieve the memory occupied by the decoded objects in bytes.
+	size_t memoryUsage() const;
+
+	/// Release all decoded objects.
+	void clear();
+};
+
+} // namespace snailviewer.
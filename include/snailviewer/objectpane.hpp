@@ -0,0 +1,102 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/objectpane.hpp
+ * @author Haoran Luo
+ * @brief The pane showing the objects of the current footprint.
+ *
+ * The pane renders only the rows inside its window, each located in
+ * the object tree model, so the number and width of the objects never
+ * matter. Moving the cursor damages only the rows it leaves and enters,
+ * and expanding or collapsing damages only the rows below the cursor.
+ */
+#include "snailviewer/objecttree.hpp"
+#include "snailviewer/widget.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace snailviewer {
+
+/**
+ * @brief The pane of the object tree.
+ *
+ * The first row shows the footprint and the number of rows, followed
+ * by the indented rows of the tree.
+ */
+class objectPane : public widget {
+	/// The log whose objects are shown.
+	const snailLog& log;
+
+	/// The cache of the decoded objects.
+	objectCache& cache;
+
+	/// The model of the tree.
+	objectTreeModel model;
+
+	/// The footprint shown, or absent.
+	uint32_t footprint;
+
+	/// The message shown when the objects cannot be shown.
+	std::string message;
+
+	/// The row of the cursor in the tree.
+	size_t cursor;
+
+	/// The row of the tree shown on the first row of objects.
+	size_t top;
+
+	/// Render the text of the row.
+	std::string rowText(int row) const;
+
+	/// Retrieve the row of the tree row, or -1 if it is not shown.
+	int rowOf(size_t treeRow) const;
+
+	/// Scroll so that the cursor is shown, returning whether scrolled.
+	bool follow();
+protected:
+	virtual void paint(cursesWindow* window, const rect& area) override;
+public:
+	/// The uid of the object pane.
+	static constexpr uid paneId() {
+		return makeUid(uidType::widget, "SNAIL", "HL", "OBJECT");
+	}
+
+	/// Construct the pane showing nothing.
+	objectPane(const snailLog& log, objectCache& cache);
+
+	/// Show the objects of the footprint, where absent shows nothing.
+	void show(uint32_t footprint);
+
+	/// Move the cursor by the number of rows, negative for upwards.
+	void move(long rows);
+
+	/// Expand the row under the cursor, or collapse it if expanded.
+	void toggle();
+
+	/// Retrieve the row of the cursor in the tree.
+	size_t cursorRow() const noexcept { return cursor; }
+
+	/// Retrieve the model of the tree.
+	const objectTreeModel& tree() const noexcept { return model; }
+};
+
+} // namespace snailviewer.
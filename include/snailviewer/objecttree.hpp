@@ -0,0 +1,215 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/objecttree.hpp
+ * @author Haoran Luo
+ * @brief The model of the expandable tree of the objects of a footprint.
+ *
+ * A struct may have hundreds of thousands of fields, so the visible
+ * rows are never materialized. Instead only the expanded nodes are
+ * kept, each knowing the number of rows its expanded descendants add.
+ * The expanded children of a node are kept in a treap ordered by their
+ * indices, where each knows the rows of the children in its subtree.
+ * Locating a row walks down through the expanded nodes, and expanding
+ * or collapsing a node adjusts the counts of its ancestors, so both
+ * cost the depth times the logarithm of the expanded siblings, however
+ * wide the objects are and however many of them are expanded.
+ */
+#include "snailviewer/objectcache.hpp"
+#include "snailviewer/snaillog.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The information of a visible row.
+ */
+struct objectRow {
+	/// The depth of the row, where the scopes are of depth 0.
+	uint32_t depth;
+
+	/// Whether the row could be expanded.
+	bool expandable;
+
+	/// Whether the row is expanded.
+	bool expanded;
+
+	/// The scope, binding or field name of the row.
+	uint32_t name;
+
+	/// The object of the row, or absent for the scopes.
+	uint32_t object;
+};
+
+/**
+ * @brief The model of the object tree of a footprint.
+ *
+ * The top level rows are the scopes of the bindings in the order they
+ * first appear, which are expanded initially. Their children are the
+ * bindings, whose children are the fields of their objects.
+ */
+class objectTreeModel {
+	/// The expanded node of the tree, which is also the node of the
+	/// treap of the expanded children of its parent.
+	struct node {
+		/// The object of the node, or absent for the scopes and root.
+		uint32_t object;
+
+		/// The index of the node among its siblings.
+		uint32_t index;
+
+		/// The number of children.
+		size_t children;
+
+		/// The rows added by the expanded descendants.
+		size_t extra;
+
+		/// The parent of the node, or null for the root.
+		node* parent;
+
+		/// The priority of the node in the treap, derived from its index.
+		uint32_t priority;
+
+		/// The rows of the nodes in the subtree of the treap rooted here.
+		size_t subtreeRows;
+
+		/// The subtrees of the treap, of lower and higher indices.
+		std::unique_ptr<node> left, right;
+
+		/// The root of the treap of the expanded children.
+		std::unique_ptr<node> expanded;
+
+		/// Retrieve the rows of the children and their descendants.
+		size_t rows() const noexcept { return children + extra; }
+	};
+
+	/// The position of a row in the tree.
+	struct position {
+		/// The parent of the row.
+		const node* parent;
+
+		/// The index of the row among its siblings.
+		uint32_t index;
+
+		/// The depth of the row.
+		uint32_t depth;
+	};
+
+	/// The log whose objects are shown.
+	const snailLog* log;
+
+	/// The decoded objects of lazily loaded logs, or null.
+	std::shared_ptr<const decodedObjects> decoded;
+
+	/// The scopes in the order they first appear.
+	std::vector<uint32_t> scopes;
+
+	/// The bindings of each scope.
+	std::vector<std::vector<uint32_t>> scopeBindings;
+
+	/// The virtual root, whose children are the scopes.
+	node root;
+
+	/// Retrieve the names, objects and bindings shown.
+	const symbolTable& names() const;
+	const objectStore& objects() const;
+	const objectBinding& binding(uint32_t index) const;
+
+	/// Retrieve the rows of the nodes in the treap.
+	static size_t treapRows(const std::unique_ptr<node>& treap) noexcept {
+		return treap != nullptr? treap->subtreeRows : 0;
+	}
+
+	/// Recompute the rows of the subtree of the treap rooted at the node.
+	static void update(node& root) noexcept {
+		root.subtreeRows = treapRows(root.left) +
+			root.rows() + treapRows(root.right);
+	}
+
+	/// Split the treap into the nodes of indices lower than the index
+	/// and the others.
+	static void split(std::unique_ptr<node> treap, uint32_t index,
+		std::unique_ptr<node>& lower, std::unique_ptr<node>& higher);
+
+	/// Merge the treaps, where the indices of the former are lower.
+	static std::unique_ptr<node> merge(std::unique_ptr<node> lower,
+		std::unique_ptr<node> higher);
+
+	/// Find the expanded child of the node by its index, or null.
+	static node* find(const node& parent, uint32_t index) noexcept;
+
+	/// Insert the expanded child into the node.
+	static void insert(node& parent, std::unique_ptr<node> child);
+
+	/// Add the rows expanded under the node to it and its ancestors, or
+	/// remove the rows collapsed.
+	static void propagate(node& parent, size_t rows, bool removed) noexcept;
+
+	/// Locate the row in the tree.
+	position locate(size_t row) const;
+
+	/// Retrieve the object and name of the child of the node.
+	void child(const node& parent, uint32_t index,
+		uint32_t depth, uint32_t& object, uint32_t& name) const;
+
+	/// Retrieve the number of children of the object.
+	size_t childCount(uint32_t object) const;
+public:
+	/// Construct the model showing nothing.
+	objectTreeModel();
+
+	/**
+	 * @brief Show the objects of the footprint, collapsing everything
+	 * but the scopes.
+	 *
+	 * The objects of lazily loaded logs, as told to the cache, are
+	 * decoded via the cache.
+	 *
+	 * @throw jsonError when the objects are malformed.
+	 */
+	void reset(const snailLog& log, uint32_t footprint, objectCache& cache);
+
+	/// Show nothing.
+	void clear();
+
+	/// Retrieve the number of visible rows.
+	size_t rows() const noexcept { return root.rows(); }
+
+	/// Retrieve the information of the visible row.
+	objectRow at(size_t row) const;
+
+	/// Render the text of the row, without indentation.
+	std::string text(const objectRow& row, size_t limit) const;
+
+	/// Expand the row if it is expandable and collapsed, returning the
+	/// number of rows added.
+	size_t expand(size_t row);
+
+	/// Collapse the row if it is expanded, returning the number of rows
+	/// removed.
+	size_t collapse(size_t row);
+};
+
+} // namespace snailviewer.
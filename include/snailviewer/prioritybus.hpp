@@ -0,0 +1,124 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/prioritybus.hpp
+ * @author Haoran Luo
+ * @brief The event bus scheduling events by their priority classes.
+ *
+ * The keystrokes and redraws must be handled at once, while the
+ * loaders and searchers may flood the bus with progress and hits. So
+ * the events are queued by their priority classes, where the urgent
+ * events are always broadcast first, and the background events are
+ * broadcast in bounded batches between them.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/eventbus.hpp"
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The event bus broadcasting events by their priority classes.
+ *
+ * The events could be raised on any thread, and they are broadcast
+ * when the bus is flushed, which broadcasts:
+ * - The urgent events, one by one in the order they are raised.
+ * - The normal events, one by one in the order they are raised.
+ * - The background events, at most the batch limit of them. They are
+ * grouped by their uids, and each group is delivered to the handlers
+ * as a batch, in the order that their uids first appear. The urgent
+ * events raised meanwhile are broadcast before each batch.
+ *
+ * The handlers must subscribe, unsubscribe and be flushed on the same
+ * thread, usually the thread of the user interface. The normal and
+ * background events raised by the handlers while flushing are broadcast
+ * on next flush.
+ *
+ * Destroying the bus discards the events pending.
+ */
+class priorityEventBus : public eventBus {
+	/// The event waiting to be broadcast.
+	struct pendingEvent {
+		/// The uid of the event.
+		uid id;
+
+		/// The holder of the event.
+		std::unique_ptr<eventHolder> holder;
+	};
+
+	/// The handlers of the events.
+	handlerTable handlers;
+
+	/// The mutex guarding the pending events.
+	std::mutex pendingMutex;
+
+	/// The urgent and normal events pending.
+	std::vector<pendingEvent> urgent, normal;
+
+	/// The background events pending.
+	std::deque<pendingEvent> background;
+
+	/// The events being flushed one by one and in batches, kept for
+	/// reusing their capacity.
+	std::vector<pendingEvent> flushing, batching;
+
+	/// The events of the batch being broadcast.
+	std::vector<const void*> batch;
+
+	/// Broadcast the events being flushed one by one, returning the
+	/// number of events broadcast.
+	size_t deliver();
+
+	/// Broadcast the urgent events pending.
+	size_t deliverUrgent();
+
+	virtual void subscribe(uid id, eventHandler<void*>& h) override;
+	virtual void unsubscribe(uid id, eventHandler<void*>& h) override;
+	virtual void broadcast(uid id, std::unique_ptr<eventHolder> evh) override;
+public:
+	/// The default maximum number of background events per flush.
+	static constexpr size_t defaultBatchLimit = 1024;
+
+	/// Broadcast strongly typed events.
+	using eventBus::broadcast;
+
+	/// Broadcast the pending events, with at most batchLimit background
+	/// events, returning the number of events broadcast.
+	size_t flush(size_t batchLimit = defaultBatchLimit);
+
+	/// Retrieve the number of events pending.
+	size_t backlog();
+
+	/// Retrieve the statistics of the bus, or null if not instrumented.
+	eventStatistics* statistics() const noexcept { return handlers.statistics(); }
+
+	/// Set the activator of the events, which should be done before the
+	/// bus is shared among threads.
+	void activateBy(eventActivator* activator) noexcept {
+		handlers.activateBy(activator);
+	}
+};
+
+} // namespace snailviewer.
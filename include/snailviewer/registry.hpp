@@ -0,0 +1,195 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/registry.hpp
+ * @author Haoran Luo
+ * @brief The registry of the modules and their components.
+ *
+ * Loading a module maps the shared object, which runs its static
+ * constructors, and calls its entry function for the descriptor. The
+ * modules should keep both trivial, leaving the real work to their
+ * initialize functions. The components are indexed by their uids in a
+ * sorted table, and the module of a component is initialized when the
+ * component is first acquired: an event when it is first dispatched
+ * by a bus activated by the registry, and a widget when the viewer
+ * first creates it.
+ */
+#include "snailviewer/eventbus.hpp"
+#include "snailviewer/module.hpp"
+#include "snailviewer/uid.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/// The variable of the environment naming the directory of the modules
+/// loaded by the viewer.
+constexpr const char* moduleDirectoryVariable = "SNAIL_MODULES";
+
+/**
+ * @brief The error raised when a module cannot be loaded or initialized.
+ */
+class moduleError : public std::runtime_error {
+public:
+	/// Construct the error with the message.
+	moduleError(const std::string& message): std::runtime_error(message) {}
+};
+
+/**
+ * @brief The registry of the modules.
+ *
+ * The registry could be used from multiple threads. The modules are
+ * finalized in the reverse order of their initialization, and unloaded
+ * when the registry is destroyed.
+ */
+class moduleRegistry : public eventActivator {
+	/// The loaded module.
+	struct loadedModule {
+		/// The path of the shared object, or empty for the modules
+		/// linked into the viewer.
+		std::string path;
+
+		/// The handle of the shared object, or null.
+		void* handle;
+
+		/// The descriptor of the module.
+		const moduleDescriptor* descriptor;
+
+		/// Whether the module has been initialized.
+		bool initialized;
+	};
+
+	/// The component indexed.
+	struct componentEntry {
+		/// The uid of the component.
+		uid id;
+
+		/// The index of the module.
+		uint32_t module;
+
+		/// The index of the component inside the module.
+		uint32_t component;
+	};
+
+	/// The facilities provided to the modules.
+	moduleContext context;
+
+	/// The loaded modules.
+	std::vector<std::unique_ptr<loadedModule>> modules;
+
+	/// The components sorted by their uids.
+	std::vector<componentEntry> components;
+
+	/// The indices of the initialized modules in initialization order.
+	std::vector<uint32_t> initializeOrder;
+
+	/// The errors of the modules failing to activate.
+	std::vector<std::string> failures;
+
+	/// The mutex guarding the registry. It is recursive since modules
+	/// may acquire components of other modules while initializing.
+	mutable std::recursive_mutex mutex;
+
+	/// Find the component entry, or null.
+	const componentEntry* lookup(uid id) const;
+
+	/// Validate and index the module, which is owned by the registry
+	/// afterwards.
+	void add(std::unique_ptr<loadedModule> module);
+public:
+	/// Construct the empty registry with the facilities for modules.
+	explicit moduleRegistry(const moduleContext& context);
+
+	/// Finalize and unload the modules.
+	~moduleRegistry();
+
+	/// The registry owns the handles and could not be copied.
+	moduleRegistry(const moduleRegistry&) = delete;
+	moduleRegistry& operator=(const moduleRegistry&) = delete;
+
+	/**
+	 * @brief Load the module from the shared object.
+	 *
+	 * @throw moduleError when the shared object is not a valid module,
+	 * or its uids collide with the loaded ones.
+	 */
+	void load(const std::string& path);
+
+	/**
+	 * @brief Register the module linked into the viewer.
+	 *
+	 * @throw moduleError when the descriptor is invalid, or its uids
+	 * collide with the loaded ones.
+	 */
+	void add(const moduleDescriptor& descriptor);
+
+	/**
+	 * @brief Load the shared objects (".so" files) in the directory in
+	 * the order of their names, returning the number of modules loaded.
+	 *
+	 * The modules failing to load are skipped, with their errors
+	 * appended to the errors if it is not null.
+	 *
+	 * @throw std::system_error when the directory cannot be read.
+	 */
+	size_t loadDirectory(const std::string& directory,
+		std::vector<std::string>* errors = nullptr);
+
+	/// Retrieve the declared component, or null if it is unknown. The
+	/// module is not initialized.
+	const moduleComponent* find(uid id) const;
+
+	/// Retrieve the uids of the components of the type, in the order
+	/// of the uids.
+	std::vector<uid> list(uidType type) const;
+
+	/**
+	 * @brief Retrieve the implementation of the component, initializing
+	 * its module if it has not been initialized.
+	 *
+	 * @return the implementation, or null if the component is unknown
+	 * or the module resolves nothing for it.
+	 * @throw moduleError when the module fails to initialize.
+	 */
+	const void* acquire(uid id);
+
+	/// Whether the module of the component has been initialized.
+	bool initialized(uid id) const;
+
+	/// Initialize the module declaring the event when it is dispatched
+	/// for the first time, so that the handlers of the module subscribe
+	/// before it is delivered. The errors are kept rather than thrown
+	/// into the bus dispatching the event.
+	virtual void activate(uid id) override;
+
+	/// Retrieve and forget the errors of the modules failing to activate.
+	std::vector<std::string> takeFailures();
+
+	/// Retrieve the number of modules loaded.
+	size_t moduleCount() const;
+};
+
+} // namespace snailviewer.
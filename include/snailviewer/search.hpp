@@ -0,0 +1,209 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/search.hpp
+ * @author Haoran Luo
+ * @brief Searching the footprints matching a query on a thread pool.
+ *
+ * The footprints are scanned in blocks on a thread pool, and the hits
+ * of the blocks are merged in footprint order and announced through
+ * the event bus as they are found. The hits are kept sorted, so moving
+ * to the next or previous hit is a binary search instead of a rescan.
+ *
+ * The conditions on the columns are checked first, where the regular
+ * expressions are matched once per function or file instead of once
+ * per footprint. Only the footprints passing them have their objects
+ * decoded and checked.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/snaillog.hpp"
+#include "snailviewer/threadpool.hpp"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The condition on an object bound to the footprint.
+ */
+struct bindingCondition {
+	/// The scope of the binding, or empty for any scope.
+	std::string scope;
+
+	/// The name of the binding, followed by the names of the fields
+	/// separated by dots, like "p.x".
+	std::string path;
+
+	/// The JSON text of the literal object, like "42" or "\"hi\"".
+	std::string value;
+};
+
+/**
+ * @brief The query of the footprints, where all conditions must hold.
+ */
+struct searchQuery {
+	/// The regular expression the function name matches, or empty.
+	std::string function;
+
+	/// The regular expression the file path matches, or empty.
+	std::string file;
+
+	/// The line of the footprint, or absent.
+	uint32_t line;
+
+	/// The conditions on the bound objects.
+	std::vector<bindingCondition> bindings;
+
+	/// The text that some literal object contains, or empty.
+	std::string text;
+
+	/// Construct the query matching every footprint.
+	searchQuery(): line(absent) {}
+};
+
+/**
+ * @brief Parse the query from its text.
+ *
+ * The text is separated by spaces into terms: "function~<regex>",
+ * "file~<regex>", "line=<number>", "[<scope>:]<path>==<value>", and
+ * the words of the text to contain otherwise. For example, the text
+ * "function~^main$ local:x==42" finds where local x is 42 in main.
+ *
+ * @throw std::invalid_argument when the line is not a number.
+ */
+searchQuery parseQuery(const std::string& text);
+
+/**
+ * @brief The event that hits of the search are found.
+ */
+struct searchHitsEvent {
+	static constexpr uid id() {
+		return makeUid(uidType::event, "SNAIL", "HL", "SEARCH");
+	}
+
+	static constexpr eventPriority priority = eventPriority::background;
+
+	/// The generation of the search, see also searchEngine::start.
+	uint64_t generation;
+
+	/// The hits [begin, end) found, indexed in footprint order.
+	size_t begin, end;
+
+	/// The footprints [0, scanned) are scanned.
+	uint32_t scanned;
+
+	/// Whether the search is finished.
+	bool finished;
+};
+
+/**
+ * @brief The engine searching the footprints of a log.
+ *
+ * The footprints may be searched while the later ones are loading,
+ * see also loadObserver for what could be read. The events are raised
+ * on the thread of the engine.
+ */
+class searchEngine {
+	/// The matcher of the footprints compiled from the query.
+	class footprintMatcher;
+
+	/// The log to search.
+	const snailLog& log;
+
+	/// The bus to raise the events.
+	eventBus& bus;
+
+	/// The thread merging the hits of the blocks in order.
+	std::thread merger;
+
+	/// The generation of the current search, where the scanning of the
+	/// other generations stops.
+	std::atomic<uint64_t> generation;
+
+	/// The mutex guarding the hits and the progress.
+	mutable std::mutex hitMutex;
+
+	/// The footprints matching the query, in ascending order.
+	std::vector<uint32_t> hitList;
+
+	/// The number of footprints scanned.
+	uint32_t scannedCount;
+
+	/// Whether the current search is finished.
+	bool done;
+
+	/// The pool scanning the blocks, which is destroyed first since
+	/// the blocks refer to the generation.
+	threadPool pool;
+
+	/// The routine of the merger.
+	void merge(std::shared_ptr<const footprintMatcher> matcher,
+		uint64_t current, uint32_t count);
+public:
+	/// Construct the engine searching on the number of threads, or
+	/// all hardware threads if 0.
+	searchEngine(const snailLog& log, eventBus& bus, size_t threads = 0);
+
+	/// Cancel the search and wait for it.
+	~searchEngine();
+
+	searchEngine(const searchEngine&) = delete;
+	searchEngine& operator=(const searchEngine&) = delete;
+
+	/**
+	 * @brief Start searching the footprints [0, count), cancelling the
+	 * search in progress, returning the generation of the search.
+	 *
+	 * The footprints to search must have been loaded, and whether their
+	 * objects are lazy must be told from logOpenedEvent, since the log
+	 * could not tell it while loading.
+	 *
+	 * @throw std::regex_error when the regular expressions are invalid.
+	 */
+	uint64_t start(const searchQuery& query, size_t count, bool lazy);
+
+	/// Cancel the search in progress and forget the hits.
+	void cancel();
+
+	/// Retrieve the first hit at or after the footprint, or absent if
+	/// none is found yet.
+	uint32_t nextHit(uint32_t footprint) const;
+
+	/// Retrieve the last hit at or before the footprint, or absent.
+	uint32_t previousHit(uint32_t footprint) const;
+
+	/// Retrieve the number of hits found.
+	size_t hits() const;
+
+	/// Retrieve the number of footprints scanned.
+	uint32_t scanned() const;
+
+	/// Whether the search is finished.
+	bool finished() const;
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,376 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/snaillog.hpp
+ * @author Haoran Luo
+ * @brief In-memory presentation of a loaded snail log.
+ *
+ * The entities described in format-latest.md are flattened into
+ * tables with 32-bit indices referring to each other, instead of
+ * trees of dynamically allocated nodes. So a loaded snail log costs
+ * only a fraction of its text size.
+ */
+#include "snailviewer/footprinttree.hpp"
+#include "snailviewer/mapping.hpp"
+#include "snailviewer/symbol.hpp"
+#include "snailviewer/table.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/// The index used for indicating an abscent reference.
+constexpr uint32_t absent = 0xffffffffu;
+
+/**
+ * @brief The trait of an object, see also the Object Entity section.
+ */
+enum class objectTrait : uint8_t {
+	/// The object data is presented to the user directly. The unknown
+	/// traits are also treated as literals.
+	literal = 0,
+
+	/// The object is formed of fields that could be expanded.
+	structure,
+};
+
+/**
+ * @brief The flattened object entity.
+ *
+ * For literals, the range refers to the JSON text of the data inside
+ * the literal heap. For structures, the range refers to the fields.
+ */
+struct objectNode {
+	/// The trait of the object.
+	objectTrait trait;
+
+	/// The type name of the object, or absent.
+	uint32_t type;
+
+	/// The beginning of the data range.
+	uint32_t begin;
+
+	/// The length of the data range.
+	uint32_t count;
+};
+
+/**
+ * @brief The field of a structure object.
+ */
+struct objectField {
+	/// The name of the field.
+	uint32_t name;
+
+	/// The object id of the field value.
+	uint32_t object;
+};
+
+/**
+ * @brief The statistics of object deduplication.
+ */
+struct objectStatistics {
+	/// The number of objects added.
+	uint64_t added;
+
+	/// The number of distinct objects stored.
+	uint64_t stored;
+
+	/// The bytes of nodes, fields and literals that have been added.
+	uint64_t addedBytes;
+
+	/// The bytes of nodes, fields and literals that have been stored.
+	uint64_t storedBytes;
+
+	/// Retrieve the ratio of added objects to stored objects.
+	double ratio() const noexcept {
+		return stored == 0? 1.0 : (double)added / (double)stored;
+	}
+};
+
+/**
+ * @brief The storage of all flattened objects.
+ *
+ * The objects are hash-consed: adding an object identical (of the same
+ * trait, type and data) to a stored one returns the id of the stored
+ * one. Since the fields refer to object ids, and the fields are always
+ * added before their structs, comparing two structs is comparing their
+ * fields' ids instead of their whole trees.
+ */
+class objectStore {
+	/// The object nodes indexed by object ids.
+	table<objectNode> nodes;
+
+	/// The fields of all structure objects.
+	table<objectField> fieldList;
+
+	/// The JSON text of all literal objects.
+	table<char> heap;
+
+	/// The structural hashes of the objects, which is dropped when the
+	/// objects could have been modified, and rebuilt on next addition.
+	std::vector<uint32_t> hashes;
+
+	/// The open addressing table of object ids keyed by hashes, where
+	/// the empty slots are absent.
+	std::vector<uint32_t> slots;
+
+	/// Rebuild the hash table, and the hashes if they have been dropped.
+	void reindex();
+
+	/// Drop the hashes and the hash table.
+	void dropIndex();
+
+	/// The statistics of deduplication.
+	objectStatistics stats;
+
+	/// Find the slot for the object of the hash, given the function
+	/// telling whether a stored object is the one.
+	template<typename matchType>
+	uint32_t& probe(uint32_t hash, matchType match);
+
+	/// Record a newly stored object into the hash table.
+	void remember(uint32_t& slot, uint32_t hash);
+public:
+	/// Construct an empty owned store.
+	objectStore();
+
+	/// Add a literal object with its JSON text, returning the id of the
+	/// identical stored object if there's any.
+	uint32_t addLiteral(uint32_t type, const char* data, size_t length);
+
+	/// Add a structure object with its fields, returning the id of the
+	/// identical stored object if there's any.
+	uint32_t addStruct(uint32_t type, const objectField* fields, size_t count);
+
+	/// Retrieve the statistics of deduplication.
+	const objectStatistics& statistics() const noexcept { return stats; }
+
+	/// Retrieve the object node by its id.
+	const objectNode& operator[](uint32_t id) const { return nodes[id]; }
+
+	/// Retrieve the number of objects.
+	size_t size() const noexcept { return nodes.size(); }
+
+	/// Retrieve the JSON text of a literal object.
+	std::string literal(const objectNode& node) const {
+		return std::string(heap.data() + node.begin, node.count);
+	}
+
+	/// Retrieve the first character of a literal object's JSON text.
+	const char* literalData(const objectNode& node) const {
+		return heap.data() + node.begin;
+	}
+
+	/// Retrieve the first field of a structure object.
+	const objectField* fields(const objectNode& node) const {
+		return fieldList.data() + node.begin;
+	}
+
+	/// Rewrite the field values, used for resolving references.
+	objectField* mutableFields() { dropIndex(); return fieldList.mutableData(); }
+
+	/// Retrieve the number of fields of all structure objects.
+	size_t fieldCount() const noexcept { return fieldList.size(); }
+
+	/// Retrieve the underlying tables.
+	const table<objectNode>& nodeTable() const noexcept { return nodes; }
+	const table<objectField>& fieldTable() const noexcept { return fieldList; }
+	const table<char>& heapTable() const noexcept { return heap; }
+
+	/// Borrow the underlying tables from elsewhere, the store is then
+	/// read-only.
+	void borrow(const objectNode* nodeData, size_t nodeCount,
+			const objectField* fieldData, size_t fieldCount,
+			const char* heapData, size_t heapSize);
+
+	/// Release the over-allocated memory after loading.
+	void shrink();
+};
+
+/**
+ * @brief The object captured by a footprint under specified scope.
+ */
+struct objectBinding {
+	/// The scope (local, args, etc.) of the object.
+	uint32_t scope;
+
+	/// The name of the object inside the scope.
+	uint32_t name;
+
+	/// The object id of the bound value.
+	uint32_t object;
+};
+
+/**
+ * @brief The flattened footprint entities, stored column by column.
+ *
+ * Walking up a stack touches only the parent column, and filtering
+ * by file or function touches only the file or function column, so
+ * each column is a contiguous table of 32-bit indices. Absent values
+ * are stored as absent.
+ *
+ * The bindings of the i-th footprint are [binding[i], binding[i + 1])
+ * in the bindings table, so the binding column has one more entry.
+ */
+struct footprintTable {
+	/// The index of parent footprint, or absent for roots.
+	table<uint32_t> parent;
+
+	/// The index of source file, or absent.
+	table<uint32_t> file;
+
+	/// The current executing line, or absent.
+	table<uint32_t> line;
+
+	/// The index of current executing function, or absent.
+	table<uint32_t> function;
+
+	/// The offsets of the bindings captured by the footprints.
+	table<uint32_t> binding;
+
+	/// Construct an empty owned footprint table.
+	footprintTable() { binding.push_back(0); }
+
+	/// Retrieve the number of footprints.
+	size_t size() const noexcept { return parent.size(); }
+
+	/// Retrieve the beginning of the bindings of the footprint.
+	uint32_t bindingBegin(uint32_t i) const { return binding[i]; }
+
+	/// Retrieve the end of the bindings of the footprint.
+	uint32_t bindingEnd(uint32_t i) const { return binding[i + 1]; }
+
+	/// Append a footprint to the owned table, whose bindings end at
+	/// the specified offset.
+	void push_back(uint32_t parentIndex, uint32_t fileIndex,
+			uint32_t lineNo, uint32_t functionIndex, uint32_t bindingEnd) {
+		parent.push_back(parentIndex);
+		file.push_back(fileIndex);
+		line.push_back(lineNo);
+		function.push_back(functionIndex);
+		binding.push_back(bindingEnd);
+	}
+
+	/// Release the over-allocated memory of the owned table.
+	void shrink() {
+		parent.shrink(); file.shrink(); line.shrink();
+		function.shrink(); binding.shrink();
+	}
+};
+
+/**
+ * @brief The range of JSON text.
+ */
+struct textRange {
+	/// The beginning of the text, or null when there's no text.
+	const char* begin;
+
+	/// The end of the text.
+	const char* end;
+};
+
+/**
+ * @brief The objects of a footprint decoded on demand.
+ *
+ * The names and objects are decoded into their own tables, so that
+ * the decoded footprints are independent of each other, and could be
+ * released independently. The root objects referred by the footprint
+ * are copied into the objects.
+ */
+struct decodedObjects {
+	/// The symbols of the names inside the objects.
+	symbolTable names;
+
+	/// The objects of the bindings.
+	objectStore objects;
+
+	/// The bindings of the footprint.
+	table<objectBinding> bindings;
+
+	/// Retrieve the number of bytes occupied by the tables.
+	size_t memoryUsage() const noexcept {
+		const stringTable& strings = names.strings();
+		return strings.offsetTable().size() * sizeof(uint64_t) +
+			strings.charTable().size() + names.size() * 2 * sizeof(uint32_t) +
+			objects.nodeTable().size() * sizeof(objectNode) +
+			objects.fieldTable().size() * sizeof(objectField) +
+			objects.heapTable().size() +
+			bindings.size() * sizeof(objectBinding);
+	}
+};
+
+/**
+ * @brief The loaded snail log, corresponding to the root entity.
+ *
+ * The tables are either filled by the JSON loader, or borrowed from
+ * the mapped binary snail log kept inside the log.
+ *
+ * When the log is loaded with lazy objects, the objects of footprints
+ * are not decoded while loading. Only their text ranges are recorded,
+ * and the bindings are left empty. See also objectCache.
+ */
+struct snailLog {
+	/// The version of the snail log.
+	std::string version;
+
+	/// The root directory to search the source files.
+	std::string root;
+
+	/// The paths of source files.
+	stringTable files;
+
+	/// The display names of functions.
+	stringTable functions;
+
+	/// The symbols of scope, variable, type and field names.
+	symbolTable names;
+
+	/// The storage of all objects.
+	objectStore objects;
+
+	/// The object ids of the root "objects" array.
+	table<uint32_t> rootObjects;
+
+	/// The footprints in the order of the log.
+	footprintTable footprints;
+
+	/// The tree index of the footprints.
+	footprintTree tree;
+
+	/// The bindings referred by the footprints.
+	table<objectBinding> bindings;
+
+	/// The text of the "objects" of each footprint, only when the log
+	/// is loaded with lazy objects.
+	table<textRange> objectTexts;
+
+	/// Whether the objects of footprints are decoded lazily, which is
+	/// only for the loading thread or the loaded log, since it queries
+	/// the table growing while loading.
+	bool isLazy() const noexcept { return !objectTexts.empty(); }
+
+	/// The mapped file that the borrowed tables are referring to.
+	mappedFile backing;
+};
+
+} // namespace snailviewer.
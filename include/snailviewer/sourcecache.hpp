@@ -0,0 +1,153 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/sourcecache.hpp
+ * @author Haoran Luo
+ * @brief The cache of the source files referred by the footprints.
+ *
+ * A log may refer to thousands of source files while only a few are
+ * viewed at a time. So a source file is mapped only when it is first
+ * shown, and indexed by the offsets of its lines, found by scanning the
+ * newlines with SIMD instructions. Only a bounded number of the most
+ * recently used files are kept mapped.
+ */
+#include "snailviewer/mapping.hpp"
+#include "snailviewer/snaillog.hpp"
+#include "snailviewer/table.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace snailviewer {
+
+/**
+ * @brief The mapped source file indexed by lines.
+ *
+ * The lines are numbered from 0, and the last line is counted even if
+ * it does not end with a newline. The newlines ("\n" or "\r\n") are
+ * not part of the lines.
+ */
+class sourceFile {
+	/// The content of the file.
+	mappedFile content;
+
+	/// The offsets of the lines, followed by the size of the file.
+	table<uint32_t> starts;
+public:
+	/**
+	 * @brief Map and index the source file.
+	 *
+	 * @throw std::system_error when the file cannot be mapped.
+	 * @throw std::length_error when the file is 4GiB or larger.
+	 */
+	explicit sourceFile(const std::string& path);
+
+	/// Retrieve the number of lines.
+	size_t lines() const noexcept { return starts.size() - 1; }
+
+	/// Retrieve the first character of the line.
+	const char* lineData(size_t line) const {
+		return content.data() + starts[line];
+	}
+
+	/// Retrieve the length of the line without the newline.
+	size_t lineLength(size_t line) const;
+
+	/// Retrieve the number of bytes of the line index.
+	size_t memoryUsage() const noexcept {
+		return starts.size() * sizeof(uint32_t);
+	}
+};
+
+/**
+ * @brief Find the offsets right after the newlines in the text, which
+ * are appended to the starts after being added the base.
+ */
+void scanLines(const char* data, size_t size,
+	uint32_t base, table<uint32_t>& starts);
+
+/// Retrieve the name of the instruction set scanning the newlines.
+const char* lineScanLevel() noexcept;
+
+/**
+ * @brief The cache of the source files of a log.
+ *
+ * The files are shared with the callers, so releasing them from the
+ * cache never invalidates the ones being viewed. The cache could be
+ * used from multiple threads.
+ */
+class sourceCache {
+	/// The log referring to the source files.
+	const snailLog& log;
+
+	/// The entry of the cache.
+	typedef std::pair<uint32_t, std::shared_ptr<const sourceFile>> entry;
+
+	/// The mapped files, the most recently used first.
+	std::list<entry> recent;
+
+	/// The map from file indices to their entries.
+	std::unordered_map<uint32_t, std::list<entry>::iterator> entries;
+
+	/// The maximum number of files kept.
+	size_t capacity;
+
+	/// The mutex guarding the cache.
+	mutable std::mutex mutex;
+
+	/// Release the least recently used ones until within the capacity,
+	/// while keeping the most recently used one.
+	void evict();
+public:
+	/// The default number of files kept.
+	static constexpr size_t defaultCapacity = 32;
+
+	/// Construct the cache of the log given the number of files kept.
+	explicit sourceCache(const snailLog& log,
+		size_t capacity = defaultCapacity);
+
+	/// Retrieve the path of the file, resolved against the root.
+	std::string path(uint32_t file) const;
+
+	/**
+	 * @brief Retrieve the mapped source file.
+	 *
+	 * @throw std::system_error when the file cannot be mapped.
+	 * @throw std::length_error when the file is too large.
+	 */
+	std::shared_ptr<const sourceFile> get(uint32_t file);
+
+	/// Change the number of files kept, releasing the exceeding ones.
+	void setCapacity(size_t files);
+
+	/// Retrieve the number of files kept.
+	size_t size() const;
+
+	/// Release all files.
+	void clear();
+};
+
+} // namespace snailviewer.
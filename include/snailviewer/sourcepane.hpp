@@ -0,0 +1,89 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/sourcepane.hpp
+ * @author Haoran Luo
+ * @brief The pane showing the source code around the current line.
+ *
+ * The pane renders only the lines inside its window, located with the
+ * line index of the source file, so the size of the file never matters.
+ * Moving to another line of the same file inside the window damages
+ * only the rows of the previous and the current lines.
+ */
+#include "snailviewer/sourcecache.hpp"
+#include "snailviewer/widget.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace snailviewer {
+
+/**
+ * @brief The pane of source code.
+ *
+ * The first row shows the path and the current line, followed by the
+ * numbered lines of the file. The lines are numbered from 1 as in the
+ * footprints.
+ */
+class sourcePane : public widget {
+	/// The cache of the source files.
+	sourceCache& cache;
+
+	/// The index of the file shown, or absent.
+	uint32_t fileIndex;
+
+	/// The file shown, or null.
+	std::shared_ptr<const sourceFile> file;
+
+	/// The message shown when the file cannot be shown.
+	std::string message;
+
+	/// The current line, numbered from 1.
+	size_t currentLine;
+
+	/// The line shown on the first row of code, numbered from 1.
+	size_t topLine;
+
+	/// Render the text of the row.
+	std::string rowText(int row) const;
+
+	/// Retrieve the row of the line, or -1 if it is not shown.
+	int rowOf(size_t line) const;
+protected:
+	virtual void paint(cursesWindow* window, const rect& area) override;
+public:
+	/// The uid of the source pane.
+	static constexpr uid paneId() {
+		return makeUid(uidType::widget, "SNAIL", "HL", "SOURCE");
+	}
+
+	/// Construct the pane showing nothing.
+	explicit sourcePane(sourceCache& cache);
+
+	/// Show the line of the file, where the absent file shows nothing.
+	void show(uint32_t file, uint32_t line);
+
+	/// Scroll the code by the number of rows, negative for upwards.
+	void scroll(long rows);
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,302 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/staticbus.hpp
+ * @author Haoran Luo
+ * @brief The event bus specialized for the built-in events.
+ *
+ * The built-in events of the viewer are known at compile time, so the
+ * bus could be specialized for them: a perfect hash function of their
+ * uids is found by the compiler, and broadcasting a built-in event of
+ * static type goes straight to its handlers, with neither hashing nor
+ * virtual call on the bus side. The events from loadable modules are
+ * dispatched by a handler table as usual.
+ *
+ * The built-in events must define their id() as constexpr, usually by
+ * returning makeUid(...).
+ *
+ * The bus is a library primitive for the hosts raising and handling
+ * the built-in events on the same thread, and the viewer does not use
+ * it: the events of the viewer are raised on the loading and searching
+ * threads and handed to the frame thread by the priorityEventBus, which
+ * has already erased their static types into holders by the time they
+ * are dispatched, and delivers the background ones in batches. So the
+ * dispatch of the static type, which is the point of the bus, never
+ * applies behind the priority bus, while the batches would be lost.
+ */
+#include "snailviewer/event.hpp"
+#include "snailviewer/eventbus.hpp"
+#include "snailviewer/uid.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+namespace snailviewer {
+
+// Helpers for finding the perfect hash function at compile time. The
+// recursions split the ranges into halves, so that their depth stays
+// logarithmic under the limit of constexpr evaluation.
+namespace staticHashing {
+
+/// The number of seeds to try before giving up.
+constexpr uint64_t seedLimit = 256;
+
+/// Retrieve the key of the uid.
+constexpr uint64_t key(const uid& id) {
+	return (uidWord(id, 0) * 0x9e3779b97f4a7c15ull) ^ uidWord(id, 1);
+}
+
+/// Retrieve the xor-shift-multiply step of the finalizer.
+constexpr uint64_t step(uint64_t x, unsigned shift, uint64_t multiplier) {
+	return (x ^ (x >> shift)) * multiplier;
+}
+
+/// Retrieve the slot of the key among 2^bits slots, by the multiply
+/// steps of the splitmix64 finalizer over the seeded key.
+constexpr size_t slot(uint64_t key, uint64_t seed, unsigned bits) {
+	return (size_t)(step(step(key ^ (seed * 0x9e3779b97f4a7c15ull), 30,
+		0xbf58476d1ce4e5b9ull), 27, 0x94d049bb133111ebull) >> (64 - bits));
+}
+
+/// Whether any key in [begin, end) falls in the slot.
+constexpr bool occupies(const uint64_t* keys, size_t begin, size_t end,
+		size_t target, uint64_t seed, unsigned bits) {
+	return end - begin == 0? false : end - begin == 1?
+		slot(keys[begin], seed, bits) == target :
+		occupies(keys, begin, begin + (end - begin) / 2, target, seed, bits) ||
+		occupies(keys, begin + (end - begin) / 2, end, target, seed, bits);
+}
+
+/// Whether any key in [begin, end) collides with a key after it.
+constexpr bool collides(const uint64_t* keys, size_t begin, size_t end,
+		size_t count, uint64_t seed, unsigned bits) {
+	return end - begin == 0? false : end - begin == 1?
+		occupies(keys, begin + 1, count, slot(keys[begin], seed, bits), seed, bits) :
+		collides(keys, begin, begin + (end - begin) / 2, count, seed, bits) ||
+		collides(keys, begin + (end - begin) / 2, end, count, seed, bits);
+}
+
+/// Find the first seed from the specified one making no collision, or
+/// the seedLimit if there's none.
+constexpr uint64_t findSeed(const uint64_t* keys, size_t count,
+		unsigned bits, uint64_t seed = 0) {
+	return seed == seedLimit? seedLimit : !collides(keys, 0, count, count,
+		seed, bits)? seed : findSeed(keys, count, bits, seed + 1);
+}
+
+/// Retrieve the bits of the number of slots, which is at least the
+/// square of the count, so that a seed is found in a few trials.
+constexpr unsigned slotBits(size_t count, unsigned bits = 1) {
+	return (size_t(1) << bits) >= count * count? bits : slotBits(count, bits + 1);
+}
+
+/// Retrieve the index of the type in the types, or the number of types
+/// if it is absent.
+template<typename eventType, typename... eventTypes> struct indexOf;
+
+template<typename eventType> struct indexOf<eventType> :
+	std::integral_constant<size_t, 0> {};
+
+template<typename eventType, typename headType, typename... tailTypes>
+struct indexOf<eventType, headType, tailTypes...> :
+	std::integral_constant<size_t, std::is_same<eventType, headType>::value?
+		0 : 1 + indexOf<eventType, tailTypes...>::value> {};
+
+} // namespace staticHashing.
+
+/**
+ * @brief The synchronous event bus specialized for the built-in events.
+ *
+ * It behaves like the syncEventBus: the events are broadcast at the
+ * moment they are raised, on the thread raising them, and the handlers
+ * may subscribe and unsubscribe while an event is being dispatched.
+ */
+template<typename... eventTypes>
+class staticEventBus : public eventBus {
+	/// The number of built-in events.
+	static constexpr size_t eventCount = sizeof...(eventTypes);
+	static_assert(eventCount > 0 && eventCount <= 64,
+		"The built-in events must be between 1 and 64.");
+
+	/// The uids of the built-in events.
+	static constexpr uid ids[eventCount] = { eventTypes::id()... };
+
+	/// The keys of the built-in events.
+	static constexpr uint64_t keys[eventCount] = {
+		staticHashing::key(eventTypes::id())... };
+
+	/// The bits of the number of slots.
+	static constexpr unsigned bits = staticHashing::slotBits(eventCount);
+
+	/// The seed of the perfect hash function.
+	static constexpr uint64_t seed = staticHashing::findSeed(keys, eventCount, bits);
+	static_assert(seed != staticHashing::seedLimit,
+		"The uids of the built-in events must be distinct.");
+
+	/// The index marking the empty slots.
+	static constexpr uint8_t empty = 0xff;
+
+	/// The handlers of a built-in event.
+	struct handlerList {
+		/// The handlers, where the unsubscribed ones are nulled while
+		/// dispatching, and removed afterwards.
+		std::vector<eventHandler<void*>*> handlers;
+
+		/// The number of dispatches in progress.
+		size_t dispatching;
+
+		/// Whether there are nulled handlers to remove.
+		bool dirty;
+	};
+
+	/// The index of built-in events by their slots.
+	uint8_t index[size_t(1) << bits];
+
+	/// The handlers of the built-in events.
+	handlerList lists[eventCount];
+
+	/// The handlers of the other events.
+	handlerTable fallback;
+
+	/// Find the index of the built-in event, or the eventCount if the
+	/// event is not built-in.
+	size_t find(uid id) const {
+		size_t i = index[staticHashing::slot(staticHashing::key(id), seed, bits)];
+		return i != empty && ids[i] == id? i : eventCount;
+	}
+
+	/// Invoke the handlers of the built-in event.
+	void dispatch(size_t i, const void* event) {
+		handlerList& list = lists[i];
+		eventStatistics* stats = fallback.statistics();
+		if(stats != nullptr) stats->broadcast(ids[i]);
+
+		// The handlers are indexed rather than iterated, since they
+		// might be appended while dispatching.
+		struct dispatchGuard {
+			handlerList& list;
+			dispatchGuard(handlerList& list): list(list) { ++ list.dispatching; }
+			~dispatchGuard() {
+				if(-- list.dispatching == 0 && list.dirty) {
+					list.handlers.erase(std::remove(list.handlers.begin(),
+						list.handlers.end(), nullptr), list.handlers.end());
+					list.dirty = false;
+				}
+			}
+		} guard(list);
+		for(size_t h = 0, n = list.handlers.size(); h < n; ++ h) {
+			eventHandler<void*>* handler = list.handlers[h];
+			if(handler == nullptr) continue;
+			if(stats != nullptr) {
+				typedef std::chrono::steady_clock clock;
+				std::type_index type(typeid(*handler));
+				clock::time_point start = clock::now();
+				handler->handle(event);
+				stats->handled(ids[i], type, (uint64_t)std::chrono::
+					duration_cast<std::chrono::nanoseconds>(
+						clock::now() - start).count());
+			} else handler->handle(event);
+		}
+	}
+
+	/// Broadcast the built-in event of static type.
+	template<typename eventRefType>
+	void broadcastTyped(eventRefType&& event, std::true_type) {
+		typedef typename std::decay<eventRefType>::type eventType;
+		dispatch(staticHashing::indexOf<eventType, eventTypes...>::value,
+			static_cast<const void*>(&event));
+	}
+
+	/// Broadcast the other event of static type via the holders.
+	template<typename eventRefType>
+	void broadcastTyped(eventRefType&& event, std::false_type) {
+		eventBus::broadcast(std::forward<eventRefType>(event));
+	}
+
+	virtual void subscribe(uid id, eventHandler<void*>& h) override {
+		size_t i = find(id);
+		if(i == eventCount) fallback.subscribe(id, h);
+		else lists[i].handlers.push_back(&h);
+	}
+
+	virtual void unsubscribe(uid id, eventHandler<void*>& h) override {
+		size_t i = find(id);
+		if(i == eventCount) { fallback.unsubscribe(id, h); return; }
+		handlerList& list = lists[i];
+		auto it = std::find(list.handlers.begin(), list.handlers.end(), &h);
+		if(it == list.handlers.end()) return;
+		if(list.dispatching > 0) {
+			*it = nullptr;
+			list.dirty = true;
+		} else list.handlers.erase(it);
+	}
+
+	virtual void broadcast(uid id, std::unique_ptr<eventHolder> evh) override {
+		size_t i = find(id);
+		if(i == eventCount) fallback.dispatch(id, evh->get());
+		else dispatch(i, evh->get());
+	}
+public:
+	/// Construct the bus, indexing the built-in events.
+	staticEventBus() {
+		std::fill(index, index + (size_t(1) << bits), empty);
+		for(size_t i = 0; i < eventCount; ++ i) {
+			index[staticHashing::slot(keys[i], seed, bits)] = (uint8_t)i;
+			lists[i].dispatching = 0;
+			lists[i].dirty = false;
+		}
+	}
+
+	/// Broadcast a strongly typed event, where the built-in events are
+	/// dispatched directly without being copied.
+	template<typename eventRefType> void broadcast(eventRefType&& event) {
+		typedef typename std::decay<eventRefType>::type eventType;
+		broadcastTyped(std::forward<eventRefType>(event), std::integral_constant<
+			bool, (staticHashing::indexOf<eventType, eventTypes...>::value
+				< eventCount)>());
+	}
+
+	/// Retrieve the statistics of the bus, or null if not instrumented.
+	eventStatistics* statistics() const noexcept { return fallback.statistics(); }
+
+	/// Set the activator of the events, which should be done before the
+	/// bus is shared among threads.
+	void activateBy(eventActivator* activator) noexcept {
+		fallback.activateBy(activator);
+	}
+};
+
+template<typename... eventTypes>
+constexpr uid staticEventBus<eventTypes...>::ids[];
+
+template<typename... eventTypes>
+constexpr uint64_t staticEventBus<eventTypes...>::keys[];
+
+template<typename... eventTypes>
+constexpr uint8_t staticEventBus<eventTypes...>::empty;
+
+} // namespace snailviewer.
@@ -0,0 +1,106 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/symbol.hpp
+ * @author Haoran Luo
+ * @brief The interner of the names in the snail log.
+ *
+ * The type names, field names, scope names and variable names are
+ * repeated over and over in a snail log. They are interned as symbols,
+ * which are 32-bit indices into a single arena of characters, so that
+ * each distinct name is stored once and comparing names is comparing
+ * their symbols.
+ *
+ * The symbols are stable: a symbol is never moved or reused once
+ * interned, and the symbols of a binary snail log are the same as
+ * those of the JSON snail log it was converted from.
+ */
+#include "snailviewer/table.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The table interning names into symbols.
+ *
+ * The names are concatenated in the string table serving as the arena,
+ * and looked up through an open addressing table of symbols, whose
+ * keys are the names inside the arena. So there's no per-name heap
+ * allocation in either of them.
+ */
+class symbolTable {
+	/// The arena of the names indexed by their symbols.
+	stringTable names;
+
+	/// The open addressing table of symbols keyed by the hashes of the
+	/// names, where the empty slots are 0xffffffff.
+	std::vector<uint32_t> slots;
+
+	/// Rebuild the table of symbols to have the number of slots.
+	void rehash(size_t count);
+
+	/// Find the slot of the name, which is either the slot of the
+	/// symbol or the empty slot for it.
+	size_t probe(const char* name, size_t length, uint32_t hash) const;
+public:
+	/// Construct an empty owned symbol table.
+	symbolTable();
+
+	/// Retrieve the symbol of the name, interning it if it is new.
+	uint32_t intern(const char* name, size_t length);
+
+	/// Retrieve the symbol of the name, interning it if it is new.
+	uint32_t intern(const std::string& name) {
+		return intern(name.data(), name.size());
+	}
+
+	/// Retrieve the symbol of the name without interning, or
+	/// 0xffffffff if the name has never been interned.
+	uint32_t find(const char* name, size_t length) const;
+
+	/// Retrieve the characters of the symbol, which are not terminated.
+	const char* data(uint32_t symbol) const { return names.data(symbol); }
+
+	/// Retrieve the length of the symbol.
+	size_t length(uint32_t symbol) const { return names.length(symbol); }
+
+	/// Retrieve a copy of the name of the symbol.
+	std::string operator[](uint32_t symbol) const { return names[symbol]; }
+
+	/// Retrieve the number of distinct symbols.
+	size_t size() const noexcept { return names.size(); }
+
+	/// Retrieve the underlying string table.
+	const stringTable& strings() const noexcept { return names; }
+
+	/// Borrow the names from elsewhere, the table is then read-only,
+	/// but the names could still be found.
+	void borrow(const uint64_t* offsets, size_t count,
+			const char* chars, size_t length);
+
+	/// Release the over-allocated memory of the names.
+	void shrink() { names.shrink(); }
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,222 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/table.hpp
+ * @author Haoran Luo
+ * @brief Tables of fixed-width records that are either owned or borrowed.
+ *
+ * A table filled by the JSON loader owns its records, while a table of
+ * a binary snail log borrows the records from the mapped file, so that
+ * opening a binary snail log copies nothing. Both are read in the same
+ * way, and only owned tables are permitted to be altered.
+ */
+#include "snailviewer/mapping.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace snailviewer {
+
+/// The size of the owned records from which they are stored in mapped
+/// pages, see also mapPages.
+constexpr size_t mappedTableSize = size_t(64) << 20;
+
+/**
+ * @brief The allocator of the owned records.
+ *
+ * Some tables are reserved for the most records the text could hold,
+ * so that the records are never moved while being read, which might
+ * be far beyond the records appended. So the large storages are mapped
+ * pages, where only the pages touched are committed.
+ */
+template<typename valueType> struct tableAllocator {
+	typedef valueType value_type;
+
+	tableAllocator() noexcept {}
+
+	template<typename otherType>
+	tableAllocator(const tableAllocator<otherType>&) noexcept {}
+
+	/// Allocate the storage of the records.
+	valueType* allocate(size_t count) {
+		if(count > size_t(-1) / sizeof(valueType)) throw std::bad_alloc();
+		size_t size = count * sizeof(valueType);
+		return static_cast<valueType*>(size >= mappedTableSize?
+			mapPages(size) : ::operator new(size));
+	}
+
+	/// Release the storage of the records.
+	void deallocate(valueType* records, size_t count) noexcept {
+		size_t size = count * sizeof(valueType);
+		if(size >= mappedTableSize) unmapPages(records, size);
+		else ::operator delete(records);
+	}
+};
+
+template<typename valueType, typename otherType>
+bool operator==(const tableAllocator<valueType>&,
+	const tableAllocator<otherType>&) noexcept { return true; }
+
+template<typename valueType, typename otherType>
+bool operator!=(const tableAllocator<valueType>&,
+	const tableAllocator<otherType>&) noexcept { return false; }
+
+/**
+ * @brief The table of fixed-width records.
+ */
+template<typename valueType> class table {
+	static_assert(std::is_trivially_copyable<valueType>::value,
+		"The records of table must be trivially copyable.");
+
+	/// The records owned by the table.
+	std::vector<valueType, tableAllocator<valueType>> storage;
+
+	/// The records borrowed by the table, or null if owned.
+	const valueType* borrowed;
+
+	/// The number of records borrowed.
+	size_t borrowedSize;
+public:
+	/// Construct an empty owned table.
+	table(): borrowed(nullptr), borrowedSize(0) {}
+
+	/// Borrow the records from elsewhere, which must live longer.
+	void borrow(const valueType* data, size_t size) {
+		decltype(storage)().swap(storage);
+		borrowed = data;
+		borrowedSize = size;
+	}
+
+	/// Whether the records are borrowed.
+	bool isBorrowed() const noexcept { return borrowed != nullptr; }
+
+	/// Retrieve the first record.
+	const valueType* data() const noexcept {
+		return borrowed != nullptr? borrowed : storage.data();
+	}
+
+	/// Retrieve the number of records.
+	size_t size() const noexcept {
+		return borrowed != nullptr? borrowedSize : storage.size();
+	}
+
+	/// Whether there's no record.
+	bool empty() const noexcept { return size() == 0; }
+
+	/// Retrieve the record by its index.
+	const valueType& operator[](size_t i) const { return data()[i]; }
+
+	/// Retrieve the last record.
+	const valueType& back() const { return data()[size() - 1]; }
+
+	/// Iterate over the records.
+	const valueType* begin() const noexcept { return data(); }
+	const valueType* end() const noexcept { return data() + size(); }
+
+	/// Append a record to the owned table.
+	void push_back(const valueType& value) { storage.push_back(value); }
+
+	/// Append records to the owned table.
+	void append(const valueType* first, const valueType* last) {
+		storage.insert(storage.end(), first, last);
+	}
+
+	/// Resize the owned table.
+	void resize(size_t size) { storage.resize(size); }
+
+	/// Reserve space for the owned table.
+	void reserve(size_t size) { storage.reserve(size); }
+
+	/// Retrieve the mutable records of the owned table.
+	valueType* mutableData() noexcept { return storage.data(); }
+
+	/// Retrieve the mutable last record of the owned table.
+	valueType& mutableBack() { return storage.back(); }
+
+	/// Release the over-allocated memory of the owned table.
+	void shrink() { storage.shrink_to_fit(); }
+};
+
+/**
+ * @brief The table of variable length strings.
+ *
+ * The strings are concatenated into a single character table, and
+ * they are located by a table of offsets with a sentinel at its end.
+ */
+class stringTable {
+	/// The offsets of the strings, with one more offset at the end.
+	table<uint64_t> offsets;
+
+	/// The concatenated characters of the strings.
+	table<char> chars;
+public:
+	/// Construct an empty owned string table.
+	stringTable() { offsets.push_back(0); }
+
+	/// Borrow the offsets and characters from elsewhere.
+	void borrow(const uint64_t* offsetData, size_t count,
+			const char* charData, size_t length) {
+		offsets.borrow(offsetData, count + 1);
+		chars.borrow(charData, length);
+	}
+
+	/// Append a string to the owned table, returning its index.
+	uint32_t push_back(const char* data, size_t length) {
+		chars.append(data, data + length);
+		offsets.push_back(chars.size());
+		return (uint32_t)(size() - 1);
+	}
+
+	/// Append a string to the owned table, returning its index.
+	uint32_t push_back(const std::string& value) {
+		return push_back(value.data(), value.size());
+	}
+
+	/// Retrieve the number of strings.
+	size_t size() const noexcept { return offsets.size() - 1; }
+
+	/// Retrieve the characters of the string.
+	const char* data(uint32_t i) const { return chars.data() + offsets[i]; }
+
+	/// Retrieve the length of the string.
+	size_t length(uint32_t i) const {
+		return (size_t)(offsets[i + 1] - offsets[i]);
+	}
+
+	/// Retrieve a copy of the string.
+	std::string operator[](uint32_t i) const {
+		return std::string(data(i), length(i));
+	}
+
+	/// Retrieve the table of offsets.
+	const table<uint64_t>& offsetTable() const noexcept { return offsets; }
+
+	/// Retrieve the table of characters.
+	const table<char>& charTable() const noexcept { return chars; }
+
+	/// Release the over-allocated memory of the owned table.
+	void shrink() { offsets.shrink(); chars.shrink(); }
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,101 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/threadpool.hpp
+ * @author Haoran Luo
+ * @brief Fixed size pool of worker threads.
+ *
+ * The pool runs independent tasks (encoding a range of objects, parsing
+ * a chunk of footprints, etc.) submitted by a coordinating thread, which
+ * collects the results through futures in the order it desires.
+ */
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace snailviewer {
+
+/**
+ * @brief The pool of worker threads executing submitted tasks.
+ *
+ * The tasks are executed in the order they are submitted, though
+ * they might finish in any order. Destroying the pool waits for all
+ * submitted tasks to complete.
+ */
+class threadPool {
+	/// The worker threads.
+	std::vector<std::thread> workers;
+
+	/// The tasks waiting to be executed.
+	std::deque<std::function<void()>> tasks;
+
+	/// The mutex protecting the tasks and the stopping flag.
+	std::mutex mutex;
+
+	/// The condition notified when tasks are submitted or stopping.
+	std::condition_variable condition;
+
+	/// Whether the pool is stopping.
+	bool stopping;
+
+	/// The routine of each worker thread.
+	void work();
+
+	/// Enqueue a task for execution.
+	void enqueue(std::function<void()> task);
+public:
+	/**
+	 * @brief Start the pool with specified number of workers.
+	 *
+	 * @param[in] count the number of workers, or 0 for the number
+	 * of hardware threads.
+	 */
+	explicit threadPool(size_t count = 0);
+
+	/// Wait for the tasks to complete and stop the workers.
+	~threadPool();
+
+	// The pool is neither copyable nor movable.
+	threadPool(const threadPool&) = delete;
+	threadPool& operator=(const threadPool&) = delete;
+
+	/// Retrieve the number of worker threads.
+	size_t size() const noexcept { return workers.size(); }
+
+	/// Submit a task and retrieve the future of its result.
+	template<typename taskType>
+	auto submit(taskType task) -> std::future<decltype(task())> {
+		typedef decltype(task()) resultType;
+		std::shared_ptr<std::packaged_task<resultType()>> packaged =
+			std::make_shared<std::packaged_task<resultType()>>(std::move(task));
+		std::future<resultType> result = packaged->get_future();
+		enqueue([packaged]() { (*packaged)(); });
+		return result;
+	}
+};
+
+} // namespace snailviewer.
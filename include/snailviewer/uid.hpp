@@ -27,8 +27,12 @@
  * from some modules, either built from the snail or some user provided
  * and loadable modules, while won't wish to consume up too much spaces.
  */
-#include <type_traits>
+#include "snailviewer/hashing.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <functional>
+#include <type_traits>
 
 namespace snailviewer {
 
@@ -92,19 +96,21 @@ struct uid {
 	 */
 	char name[7];
 
-	/// Compare the less relationship of two unique ids.
+	/// Compare the less relationship of two unique ids, which is the
+	/// lexicographic order of their bytes. The comparison of 16 bytes is
+	/// inlined by the compilers into a few wide loads.
 	bool operator<(const uid& opponent) const noexcept {
-		const long* a = reinterpret_cast<const long*>(this);
-		const long* b = reinterpret_cast<const long*>(&opponent);
-		if(a[0] == b[0]) return a[1] < b[1];
-		else return a[0] < b[0];
+		return std::memcmp(this, &opponent, sizeof(uid)) < 0;
 	}
 
 	/// Compare the equality relationship of two unique ids.
 	bool operator==(const uid& opponent) const noexcept {
-		const long* a = reinterpret_cast<const long*>(this);
-		const long* b = reinterpret_cast<const long*>(&opponent);
-		return a[0] == b[0] && a[1] == b[1];
+		return std::memcmp(this, &opponent, sizeof(uid)) == 0;
+	}
+
+	/// Compare the inequality relationship of two unique ids.
+	bool operator!=(const uid& opponent) const noexcept {
+		return !(*this == opponent);
 	}
 
 	/// Judge whether the id has some type.
@@ -124,14 +130,61 @@ constexpr uid null(uidType type) {
 	return uid {{0, 0, 0, 0, 0}, {0, 0, 0}, type, {0, 0, 0, 0, 0, 0, 0}};
 }
 
+/// Retrieve the character of the literal, or 0 when it is past the end.
+template<size_t size>
+constexpr char uidChar(const char (&literal)[size], size_t i) {
+	return i + 1 < size? literal[i] : 0;
+}
+
+/**
+ * @brief Construct the uid from string literals at compile time.
+ *
+ * For example, makeUid(uidType::event, "SNAIL", "HL", "FPNTIDX") is a
+ * constant identifying the event of updating current footprint index.
+ * The literals longer than their fields are rejected at compile time,
+ * and the shorter ones are padded with zeroes.
+ */
+template<size_t moduleSize, size_t authorSize, size_t nameSize>
+constexpr uid makeUid(uidType type, const char (&module)[moduleSize],
+		const char (&author)[authorSize], const char (&name)[nameSize]) {
+	static_assert(moduleSize <= 6, "The module name has at most 5 characters.");
+	static_assert(authorSize <= 4, "The author name has at most 3 characters.");
+	static_assert(nameSize <= 8, "The name has at most 7 characters.");
+	return uid {
+		{ uidChar(module, 0), uidChar(module, 1), uidChar(module, 2),
+			uidChar(module, 3), uidChar(module, 4) },
+		{ uidChar(author, 0), uidChar(author, 1), uidChar(author, 2) },
+		type,
+		{ uidChar(name, 0), uidChar(name, 1), uidChar(name, 2),
+			uidChar(name, 3), uidChar(name, 4), uidChar(name, 5),
+			uidChar(name, 6) } };
+}
+
+/// Retrieve the byte of the uid at the offset at compile time.
+constexpr uint64_t uidByte(const uid& id, size_t offset) {
+	return (uint64_t)(unsigned char)(offset < 5? id.module[offset] :
+		offset < 8? id.author[offset - 5] : offset == 8? (char)id.type :
+		id.name[offset - 9]);
+}
+
+/// Retrieve the 64-bit word of the uid's bytes [8 * half, 8 * half + 8)
+/// at compile time, with the first byte being the least significant. It
+/// could be used as a constant, e.g. a switch key, to tell the uids of
+/// the same module and author apart by their names, with half being 1.
+constexpr uint64_t uidWord(const uid& id, size_t half, size_t i = 0) {
+	return i == 8? 0 : (uidByte(id, half * 8 + i) << (8 * i)) |
+		uidWord(id, half, i + 1);
+}
+
 } // namespace snailviewer.
 
 namespace std {
 
 template<> struct hash<snailviewer::uid> {
 	size_t operator()(const snailviewer::uid& id) const noexcept {
-		const long* v = reinterpret_cast<const long*>(&id);
-		return (size_t)(v[0] ^ v[1]);
+		uint64_t words[2];
+		std::memcpy(words, &id, sizeof(words));
+		return (size_t)snailviewer::hashWide(words[0], words[1]);
 	}
 };
 
@@ -0,0 +1,244 @@
+#pragma once
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/widget.hpp
+ * @author Haoran Luo
+ * @brief The damage-tracked widgets rendered with ncurses.
+ *
+ * The viewer is often used over slow remote links, where repainting
+ * the screen on every step is painful. So each widget tracks the
+ * regions that have been damaged since last rendered, and repaints
+ * only them into its own window. The windows are then staged with
+ * wnoutrefresh and flushed once per frame with doupdate, where ncurses
+ * emits only the cells differing from the terminal.
+ *
+ * The widgets must never clear their whole windows (werase, wclear,
+ * etc.), which discards the knowledge of unchanged cells.
+ */
+#include "snailviewer/uid.hpp"
+#include <cstddef>
+#include <cstdio>
+#include <vector>
+
+/// The window of ncurses, where its header is not included here since
+/// it defines macros like move and erase.
+struct _win_st;
+
+/// The terminal of ncurses.
+struct screen;
+
+namespace snailviewer {
+
+/// The window of ncurses.
+typedef struct ::_win_st cursesWindow;
+
+/**
+ * @brief The rectangle of cells.
+ */
+struct rect {
+	/// The row of the top left cell.
+	int top;
+
+	/// The column of the top left cell.
+	int left;
+
+	/// The number of rows.
+	int height;
+
+	/// The number of columns.
+	int width;
+
+	/// Whether the rectangle has no cell.
+	bool empty() const noexcept { return height <= 0 || width <= 0; }
+
+	/// Retrieve the row past the bottom.
+	int bottom() const noexcept { return top + height; }
+
+	/// Retrieve the column past the right.
+	int right() const noexcept { return left + width; }
+
+	/// Whether the rectangle contains the other.
+	bool contains(const rect& other) const noexcept {
+		return other.top >= top && other.left >= left &&
+			other.bottom() <= bottom() && other.right() <= right();
+	}
+
+	/// Whether the rectangles overlap or touch each other.
+	bool adjoins(const rect& other) const noexcept {
+		return other.top <= bottom() && top <= other.bottom() &&
+			other.left <= right() && left <= other.right();
+	}
+
+	/// Retrieve the intersection of the rectangles.
+	rect intersect(const rect& other) const noexcept;
+
+	/// Retrieve the bounding rectangle of the rectangles.
+	rect unite(const rect& other) const noexcept;
+};
+
+/**
+ * @brief The damaged region, as a few disjoint rectangles.
+ *
+ * The adjoining rectangles are merged into their bounding rectangles,
+ * and all rectangles are merged when there are too many of them, so
+ * that the region stays cheap while repainting a few more cells.
+ */
+class damageRegion {
+	/// The rectangles of the region.
+	std::vector<rect> rects;
+public:
+	/// The maximum number of rectangles kept.
+	static constexpr size_t maxRects = 8;
+
+	/// Add the rectangle to the region.
+	void add(const rect& area);
+
+	/// Clear the region.
+	void clear() noexcept { rects.clear(); }
+
+	/// Whether the region is empty.
+	bool empty() const noexcept { return rects.empty(); }
+
+	/// Retrieve the rectangles of the region.
+	const std::vector<rect>& areas() const noexcept { return rects; }
+};
+
+/**
+ * @brief The widget owning a window of the screen.
+ *
+ * The widgets tile the screen without overlapping. The coordinates of
+ * the damaged regions and painted areas are relative to the widget.
+ */
+class widget {
+	/// The uid of the widget.
+	uid identity;
+
+	/// The window of the widget, or null before it is placed.
+	cursesWindow* window;
+
+	/// The bounds of the widget on the screen.
+	rect bounds;
+
+	/// The region to repaint.
+	damageRegion damage;
+protected:
+	/// Paint the area of the window, which must paint every cell of
+	/// the area since the area is not cleared.
+	virtual void paint(cursesWindow* window, const rect& area) = 0;
+
+	/// Fill the area with blanks, for the widgets that paint sparsely.
+	static void blank(cursesWindow* window, const rect& area);
+public:
+	/// Construct the widget with its uid, which is not placed.
+	explicit widget(uid identity): identity(identity),
+		window(nullptr), bounds(rect { 0, 0, 0, 0 }) {}
+
+	/// Destroy the window of the widget.
+	virtual ~widget();
+
+	/// The widget owns a window and could not be copied.
+	widget(const widget&) = delete;
+	widget& operator=(const widget&) = delete;
+
+	/// Retrieve the uid of the widget.
+	uid id() const noexcept { return identity; }
+
+	/// Retrieve the bounds of the widget on the screen.
+	const rect& area() const noexcept { return bounds; }
+
+	/// Retrieve the number of rows of the widget.
+	int height() const noexcept { return bounds.height; }
+
+	/// Retrieve the number of columns of the widget.
+	int width() const noexcept { return bounds.width; }
+
+	/// Place the widget on the screen, damaging the whole widget.
+	void place(const rect& bounds);
+
+	/// Damage the whole widget.
+	void invalidate() { invalidate(rect { 0, 0, bounds.height, bounds.width }); }
+
+	/// Damage the area of the widget.
+	void invalidate(const rect& area);
+
+	/// Damage the row of the widget.
+	void invalidateRow(int row) { invalidate(rect { row, 0, 1, bounds.width }); }
+
+	/// Whether the widget has been damaged since last rendered.
+	bool dirty() const noexcept { return !damage.empty(); }
+
+	/// Repaint the damaged regions and stage the window for next update,
+	/// returning whether anything has been staged.
+	bool render();
+};
+
+/**
+ * @brief The terminal where the widgets are displayed.
+ *
+ * There should be only one display at a time, since the windows of the
+ * widgets are created on the current terminal of ncurses.
+ */
+class display {
+	/// The terminal of ncurses.
+	struct ::screen* terminal;
+
+	/// The widgets displayed.
+	std::vector<widget*> widgets;
+public:
+	/// Start the terminal of the type on the files, where the null type
+	/// stands for the TERM of the environment.
+	display(FILE* output = stdout, FILE* input = stdin,
+		const char* type = nullptr);
+
+	/// Restore and release the terminal.
+	~display();
+
+	/// The display owns the terminal and could not be copied.
+	display(const display&) = delete;
+	display& operator=(const display&) = delete;
+
+	/// Retrieve the number of rows of the terminal.
+	int rows() const;
+
+	/// Retrieve the number of columns of the terminal.
+	int columns() const;
+
+	/// Display the widget, which must be removed before destroyed.
+	void add(widget& w);
+
+	/// Stop displaying the widget.
+	void remove(widget& w);
+
+	/// Render the damaged widgets and update the terminal at once,
+	/// returning the number of widgets rendered.
+	size_t render();
+
+	/// Repaint the whole terminal on next render, after the terminal
+	/// has been garbled or resized.
+	void repaint();
+
+	/// Read a key within the timeout in milliseconds, where a negative
+	/// timeout waits forever. Returns the key code of ncurses, or -1 on
+	/// timeout.
+	int readKey(int timeout);
+};
+
+} // namespace snailviewer.
@@ -0,0 +1,252 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailconv/main.cpp
+ * @author Haoran Luo
+ * @brief Entry point of snail log converter.
+ *
+ * The converter converts the JSON snail log into binary snail log, or
+ * the binary snail log back into JSON, depending on the format of the
+ * input file.
+ *
+ * When writing JSON, the objects and footprints are encoded in chunks
+ * on a thread pool, while the main thread writes the encoded chunks
+ * in order. Only a bounded number of chunks are in flight, so the
+ * memory consumed is independent of the size of the log.
+ *
+ * When writing binary, the footprints of the JSON log are parsed in
+ * chunks on a thread pool by the loader, and the bindings of each chunk
+ * are appended to the bindings section as soon as the chunk is merged,
+ * instead of being kept in memory. The other sections follow once the
+ * log is loaded, and the section directory is patched in at last. So
+ * only the deduplicated objects and the footprint columns are kept.
+ */
+#include "snailviewer/binary.hpp"
+#include "snailviewer/jsonwriter.hpp"
+#include "snailviewer/loader.hpp"
+#include "snailviewer/threadpool.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <string>
+#include <system_error>
+
+using namespace snailviewer;
+
+// Helpers for the converter.
+namespace {
+
+/// The number of objects or footprints encoded by a task.
+constexpr size_t chunkSize = 4096;
+
+/// The number of chunks in flight per worker.
+constexpr size_t chunksPerWorker = 4;
+
+/// Print the usage of the converter.
+void usage(const char* program) {
+	std::fprintf(stderr,
+		"Usage: %s [-s] [-j <threads>] <input> <output>\n"
+		"Convert a JSON snail log into binary snail log, or a binary\n"
+		"snail log into JSON, depending on the format of the input.\n"
+		"\n"
+		"  -j <threads>  number of loading and encoding threads\n"
+		"                (default: all cores)\n"
+		"  -s            print the object deduplication statistics\n",
+		program);
+}
+
+/// Print the object deduplication statistics of the log.
+void statistics(const snailLog& log) {
+	const objectStatistics& stats = log.objects.statistics();
+	std::fprintf(stderr,
+		"objects: %llu added, %llu stored (%.2fx)\n"
+		"object bytes: %llu added, %llu stored\n",
+		(unsigned long long)stats.added, (unsigned long long)stats.stored,
+		stats.ratio(), (unsigned long long)stats.addedBytes,
+		(unsigned long long)stats.storedBytes);
+}
+
+/// The writer raising errors when writing fails.
+class textWriter {
+	/// The file being written.
+	FILE* file;
+
+	/// The path of the file.
+	std::string path;
+
+	/// Raise the error from errno.
+	[[noreturn]] void fail() {
+		int error = errno;
+		throw std::system_error(error, std::system_category(),
+			"Cannot write " + path);
+	}
+public:
+	/// Open the file for writing.
+	explicit textWriter(const std::string& path): path(path) {
+		file = std::fopen(path.c_str(), "wb");
+		if(file == nullptr) fail();
+	}
+
+	/// Close the file if it has not been closed.
+	~textWriter() { if(file != nullptr) std::fclose(file); }
+
+	/// Write the text to the file.
+	void write(const std::string& text) {
+		if(!text.empty() && std::fwrite(text.data(),
+			1, text.size(), file) != text.size()) fail();
+	}
+
+	/// Flush and close the file.
+	void close() {
+		FILE* closing = file;
+		file = nullptr;
+		if(std::fclose(closing) != 0) fail();
+	}
+};
+
+/// Encode the items in chunks on the pool and write them in order.
+template<typename encoderType> void encodeChunks(threadPool& pool,
+		textWriter& writer, size_t count, encoderType encoder) {
+	std::deque<std::future<std::string>> inflight;
+	size_t window = pool.size() * chunksPerWorker;
+	for(size_t begin = 0; begin < count || !inflight.empty(); ) {
+		// Keep the window of chunks filled.
+		while(begin < count && inflight.size() < window) {
+			size_t end = std::min(count, begin + chunkSize);
+			inflight.push_back(pool.submit([=]() {
+				std::string out;
+				encoder(begin, end, out);
+				return out;
+			}));
+			begin = end;
+		}
+
+		// Write out the earliest chunk.
+		writer.write(inflight.front().get());
+		inflight.pop_front();
+	}
+}
+
+/// The consumer appending the bindings to the section being written.
+class bindingAppender : public bindingConsumer {
+	/// The writer of the binary log.
+	binaryLogWriter& writer;
+public:
+	/// Construct the consumer appending to the writer.
+	bindingAppender(binaryLogWriter& writer): writer(writer) {}
+
+	virtual void consume(const objectBinding* bindings,
+			size_t count) override {
+		writer.append(bindings, count * sizeof(objectBinding), count);
+	}
+};
+
+/// Convert the JSON snail log into binary, streaming the bindings.
+void jsonToBinary(const mappedFile& file, snailLog& log,
+		const std::string& output, size_t threads) {
+	binaryLogWriter writer(output);
+	bindingAppender appender(writer);
+	loadOptions options;
+	options.threads = threads;
+	options.bindings = &appender;
+	writer.begin(sectionKind::bindings);
+	loadJson(file.data(), file.end(), log, options);
+	writer.end();
+	writer.writeLog(log);
+	writer.close();
+}
+
+/// Convert the binary snail log into JSON.
+void binaryToJson(const snailLog& log, const std::string& output,
+		size_t threads) {
+	jsonWriter json(log);
+	textWriter writer(output);
+	threadPool pool(threads);
+	std::string text;
+
+	json.prologue(text);
+	writer.write(text);
+	encodeChunks(pool, writer, log.rootObjects.size(),
+		[&json](size_t begin, size_t end, std::string& out) {
+			json.rootObjects(begin, end, out);
+		});
+	text.clear();
+	json.interlude(text);
+	writer.write(text);
+	encodeChunks(pool, writer, log.footprints.size(),
+		[&json](size_t begin, size_t end, std::string& out) {
+			json.footprints(begin, end, out);
+		});
+	text.clear();
+	json.epilogue(text);
+	writer.write(text);
+	writer.close();
+}
+
+} // Anonymous namespace.
+
+// Implementation of the converter entry point.
+int main(int argc, char* argv[]) {
+	size_t threads = 0;
+	bool printStatistics = false;
+	int argi = 1;
+	for(; argi < argc && argv[argi][0] == '-'; ++ argi) {
+		if(std::strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+			char* end;
+			long value = std::strtol(argv[++ argi], &end, 10);
+			if(*end != '\0' || value <= 0) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			threads = (size_t)value;
+		} else if(std::strcmp(argv[argi], "-s") == 0) {
+			printStatistics = true;
+		} else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(argc - argi != 2) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::string input(argv[argi]), output(argv[argi + 1]);
+
+	try {
+		snailLog log;
+		mappedFile file(input);
+		if(isBinaryLog(file.data(), file.size())) {
+			loadBinary(std::move(file), log);
+			if(printStatistics) statistics(log);
+			binaryToJson(log, output, threads);
+		} else {
+			jsonToBinary(file, log, output, threads);
+			if(printStatistics) statistics(log);
+		}
+	} catch(const std::exception& e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
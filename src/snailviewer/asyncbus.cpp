@@ -0,0 +1,121 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/asyncbus.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the asynchronous event bus.
+ */
+#include "snailviewer/asyncbus.hpp"
+
+namespace snailviewer {
+
+// Helpers for the asynchronous event bus.
+namespace {
+
+/// The number of times the dispatcher yields before sleeping.
+constexpr int spinCount = 64;
+
+} // Anonymous namespace.
+
+constexpr size_t asyncEventBus::defaultCapacity;
+
+asyncEventBus::asyncEventBus(size_t capacity): queue(capacity),
+	sleeping(false), stopping(false) {
+	dispatcher = std::thread(&asyncEventBus::run, this);
+}
+
+asyncEventBus::~asyncEventBus() {
+	{
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		stopping.store(true);
+	}
+	wakeup.notify_one();
+	dispatcher.join();
+}
+
+void asyncEventBus::deliver(const pendingEvent& event) {
+	std::unique_ptr<eventHolder> holder(event.holder);
+	std::lock_guard<std::recursive_mutex> lock(handlerMutex);
+	handlers.dispatch(event.id, holder->get());
+}
+
+void asyncEventBus::run() {
+	pendingEvent event;
+	while(true) {
+		if(queue.pop(event)) { deliver(event); continue; }
+
+		// Yield for a while before sleeping, since the events usually
+		// come in bursts.
+		bool arrived = false;
+		for(int i = 0; i < spinCount && !arrived; ++ i) {
+			std::this_thread::yield();
+			arrived = !queue.empty();
+		}
+		if(arrived) continue;
+
+		// Announce sleeping before checking the queue again, paired with
+		// the producers posting before checking whether it is sleeping,
+		// so that either side must see the other.
+		std::unique_lock<std::mutex> lock(sleepMutex);
+		sleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		wakeup.wait(lock, [this]() {
+			return !queue.empty() || stopping.load();
+		});
+		sleeping.store(false, std::memory_order_relaxed);
+		if(queue.empty() && stopping.load()) return;
+	}
+}
+
+void asyncEventBus::subscribe(uid id, eventHandler<void*>& h) {
+	std::lock_guard<std::recursive_mutex> lock(handlerMutex);
+	handlers.subscribe(id, h);
+}
+
+void asyncEventBus::unsubscribe(uid id, eventHandler<void*>& h) {
+	std::lock_guard<std::recursive_mutex> lock(handlerMutex);
+	handlers.unsubscribe(id, h);
+}
+
+void asyncEventBus::broadcast(uid id, std::unique_ptr<eventHolder> evh) {
+	pendingEvent event;
+	event.id = id;
+	event.holder = evh.get();
+	while(!queue.push(event)) {
+		// The dispatcher would never make room for itself, so the events
+		// raised by the handlers are broadcast at once when it is full.
+		if(std::this_thread::get_id() == dispatcher.get_id()) {
+			std::lock_guard<std::recursive_mutex> lock(handlerMutex);
+			handlers.dispatch(id, evh->get());
+			return;
+		}
+		std::this_thread::yield();
+	}
+	evh.release();
+	handlers.sampleDepth(queue.size());
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if(sleeping.load(std::memory_order_relaxed)) {
+		std::lock_guard<std::mutex> lock(sleepMutex);
+		wakeup.notify_one();
+	}
+}
+
+} // namespace snailviewer.
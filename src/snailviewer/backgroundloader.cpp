@@ -0,0 +1,73 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/backgroundloader.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the background loader.
+ */
+#include "snailviewer/backgroundloader.hpp"
+
+namespace snailviewer {
+
+// Helpers for cancelling the loading.
+namespace {
+
+/// Thrown from the observer to unwind the cancelled loading.
+struct loadCancelled {};
+
+} // Anonymous namespace.
+
+backgroundLoader::backgroundLoader(eventBus& bus,
+		const std::string& path, loadOptions options):
+	bus(bus), total(0), cancelled(false) {
+	options.observer = this;
+	worker = std::thread(&backgroundLoader::load, this, path, options);
+}
+
+backgroundLoader::~backgroundLoader() {
+	cancelled.store(true, std::memory_order_relaxed);
+	worker.join();
+}
+
+void backgroundLoader::load(std::string path, loadOptions options) {
+	std::exception_ptr error;
+	try {
+		loadFile(path, log, options);
+	} catch(const loadCancelled&) {
+		return;
+	} catch(...) {
+		error = std::current_exception();
+	}
+	bus.broadcast(logLoadedEvent { &log, error });
+}
+
+void backgroundLoader::opened(const snailLog& loading,
+		size_t footprints, bool lazy) {
+	if(cancelled.load(std::memory_order_relaxed)) throw loadCancelled();
+	total = footprints;
+	bus.broadcast(logOpenedEvent { &loading, footprints, lazy });
+}
+
+void backgroundLoader::loaded(const snailLog&, uint32_t begin, uint32_t end) {
+	if(cancelled.load(std::memory_order_relaxed)) throw loadCancelled();
+	bus.broadcast(footprintsLoadedEvent { begin, end, total });
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,374 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/binary.cpp
+ * @author Haoran Luo
+ * @brief Implementation of reading and writing binary snail logs.
+ */
+#include "snailviewer/binary.hpp"
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace snailviewer {
+
+// The records are written as is, so their layout must be fixed.
+static_assert(sizeof(binaryHeader) == 24, "Unexpected header layout.");
+static_assert(sizeof(binarySection) == 32, "Unexpected section layout.");
+static_assert(sizeof(objectNode) == 16, "Unexpected object node layout.");
+static_assert(sizeof(objectField) == 8, "Unexpected object field layout.");
+static_assert(sizeof(objectBinding) == 12, "Unexpected binding layout.");
+
+// Helpers for reading and writing the sections.
+namespace {
+
+/// The alignment of the sections.
+constexpr uint64_t sectionAlignment = 8;
+
+/// Round the offset up to the section alignment.
+inline uint64_t align(uint64_t offset) noexcept {
+	return (offset + sectionAlignment - 1) & ~(sectionAlignment - 1);
+}
+
+/// The room of the directory, where each kind of section is written
+/// at most once.
+constexpr size_t directoryCapacity = (size_t)sectionKind::treeOrders;
+
+/// Locate the records of the section inside the file.
+template<typename valueType> const valueType* records(
+		const mappedFile& file, const binarySection& section) {
+	// The count is checked by division, since the product might wrap.
+	if(section.count != section.size / sizeof(valueType) ||
+		section.size % sizeof(valueType) != 0)
+		throw formatError("Malformed table section.");
+	return reinterpret_cast<const valueType*>(file.data() + section.offset);
+}
+
+/// Borrow the string table from the section inside the file.
+template<typename tableType> void borrowStrings(const mappedFile& file,
+		const binarySection& section, tableType& strings) {
+	uint64_t offsetSize = (section.count + 1) * sizeof(uint64_t);
+	if(section.count >= section.size / sizeof(uint64_t) ||
+		section.size < offsetSize)
+		throw formatError("Malformed string table section.");
+	const uint64_t* offsets = reinterpret_cast<const uint64_t*>(
+		file.data() + section.offset);
+	uint64_t length = section.size - offsetSize;
+	if(offsets[0] != 0 || offsets[section.count] != length)
+		throw formatError("Malformed string table section.");
+	for(uint64_t i = 0; i < section.count; ++ i)
+		if(offsets[i] > offsets[i + 1])
+			throw formatError("Malformed string table section.");
+	strings.borrow(offsets, (size_t)section.count,
+		file.data() + section.offset + offsetSize, (size_t)length);
+}
+
+/// Validate the references between the borrowed tables in a single
+/// pass over them, so that a corrupt file is never read outside.
+void validateReferences(const snailLog& log) {
+	size_t names = log.names.size(), objects = log.objects.size();
+	for(const objectNode& node : log.objects.nodeTable()) {
+		if(node.type != absent && node.type >= names)
+			throw formatError("Name index out of range.");
+		uint64_t end = (uint64_t)node.begin + node.count;
+		if(end > (node.trait == objectTrait::structure?
+			log.objects.fieldCount() : log.objects.heapTable().size()))
+			throw formatError("Object data out of range.");
+	}
+	for(const objectField& field : log.objects.fieldTable()) {
+		if(field.name >= names) throw formatError("Name index out of range.");
+		if(field.object >= objects)
+			throw formatError("Object index out of range.");
+	}
+	for(uint32_t object : log.rootObjects)
+		if(object >= objects) throw formatError("Object index out of range.");
+	for(const objectBinding& binding : log.bindings) {
+		if(binding.scope >= names || binding.name >= names)
+			throw formatError("Name index out of range.");
+		if(binding.object >= objects)
+			throw formatError("Object index out of range.");
+	}
+
+	const footprintTable& fp = log.footprints;
+	auto check = [](const table<uint32_t>& column, size_t count) {
+		for(uint32_t value : column)
+			if(value != absent && value >= count) throw formatError(
+				"Footprint reference out of range.");
+	};
+	check(fp.parent, fp.size());
+	check(fp.file, log.files.size());
+	check(fp.function, log.functions.size());
+	for(size_t i = 0; i < fp.size(); ++ i)
+		if(fp.binding[i] > fp.binding[i + 1])
+			throw formatError("Malformed footprint bindings.");
+	if(fp.binding.back() > log.bindings.size())
+		throw formatError("Malformed footprint bindings.");
+}
+
+} // Anonymous namespace.
+
+bool isBinaryLog(const char* data, size_t size) noexcept {
+	return size >= sizeof(binaryMagic) &&
+		std::memcmp(data, binaryMagic, sizeof(binaryMagic)) == 0;
+}
+
+void loadBinary(mappedFile file, snailLog& log) {
+	// Validate the header of the file.
+	if(file.size() < sizeof(binaryHeader) ||
+		!isBinaryLog(file.data(), file.size()))
+		throw formatError("Not a binary snail log.");
+	binaryHeader header;
+	std::memcpy(&header, file.data(), sizeof(header));
+	if(header.byteOrder != binaryByteOrder)
+		throw formatError("The binary snail log is of foreign byte order.");
+	if(header.version != binaryVersion)
+		throw formatError("The binary snail log is of unsupported version " +
+			std::to_string(header.version) + ".");
+	if(header.sectionCount > (file.size() - sizeof(binaryHeader))
+		/ sizeof(binarySection))
+		throw formatError("Malformed section directory.");
+
+	// Validate the sections and borrow the tables from them.
+	const binarySection* sections = reinterpret_cast<const binarySection*>(
+		file.data() + sizeof(binaryHeader));
+	constexpr size_t requiredCount = (size_t)sectionKind::footprintBindings + 1;
+	constexpr size_t kindCount = (size_t)sectionKind::treeOrders + 1;
+	const binarySection* found[kindCount] = {};
+	for(uint32_t i = 0; i < header.sectionCount; ++ i) {
+		const binarySection& section = sections[i];
+		if(section.offset % sectionAlignment != 0 ||
+			section.offset > file.size() ||
+			section.size > file.size() - section.offset)
+			throw formatError("Malformed section directory.");
+		size_t kind = (size_t)section.kind;
+		if(kind > 0 && kind < kindCount) found[kind] = &section;
+	}
+	for(size_t kind = 1; kind < requiredCount; ++ kind)
+		if(found[kind] == nullptr)
+			throw formatError("Missing section " + std::to_string(kind) + ".");
+	auto sectionOf = [&](sectionKind kind) -> const binarySection& {
+		return *found[(size_t)kind];
+	};
+
+	stringTable meta;
+	borrowStrings(file, sectionOf(sectionKind::meta), meta);
+	if(meta.size() < 2) throw formatError("Malformed meta section.");
+	log.version = meta[0];
+	log.root = meta[1];
+	borrowStrings(file, sectionOf(sectionKind::files), log.files);
+	borrowStrings(file, sectionOf(sectionKind::functions), log.functions);
+	borrowStrings(file, sectionOf(sectionKind::names), log.names);
+
+	const binarySection& nodes = sectionOf(sectionKind::objectNodes);
+	const binarySection& fields = sectionOf(sectionKind::objectFields);
+	const binarySection& heap = sectionOf(sectionKind::objectHeap);
+	log.objects.borrow(records<objectNode>(file, nodes), (size_t)nodes.count,
+		records<objectField>(file, fields), (size_t)fields.count,
+		records<char>(file, heap), (size_t)heap.count);
+
+	const binarySection& rootObjects = sectionOf(sectionKind::rootObjects);
+	log.rootObjects.borrow(records<uint32_t>(file, rootObjects),
+		(size_t)rootObjects.count);
+	const binarySection& bindings = sectionOf(sectionKind::bindings);
+	log.bindings.borrow(records<objectBinding>(file, bindings),
+		(size_t)bindings.count);
+
+	footprintTable& fp = log.footprints;
+	const binarySection& bindingColumn =
+		sectionOf(sectionKind::footprintBindings);
+	size_t count = (size_t)sectionOf(sectionKind::footprintParents).count;
+	if(bindingColumn.count != (uint64_t)count + 1)
+		throw formatError("Malformed footprint columns.");
+	auto column = [&](sectionKind kind, table<uint32_t>& target) {
+		const binarySection& section = sectionOf(kind);
+		if(section.count != count) throw formatError(
+			"Malformed footprint columns.");
+		target.borrow(records<uint32_t>(file, section), count);
+	};
+	column(sectionKind::footprintParents, fp.parent);
+	column(sectionKind::footprintFiles, fp.file);
+	column(sectionKind::footprintLines, fp.line);
+	column(sectionKind::footprintFunctions, fp.function);
+	fp.binding.borrow(records<uint32_t>(file, bindingColumn), count + 1);
+	validateReferences(log);
+
+	// Borrow the tree index if it is present, or build it otherwise.
+	bool indexed = true;
+	for(size_t kind = (size_t)sectionKind::treeChildOffsets;
+		kind < kindCount; ++ kind) {
+		size_t expected = kind == (size_t)sectionKind::treeChildOffsets?
+			count + 2 : count;
+		if(found[kind] == nullptr) indexed = false;
+		else if(found[kind]->count != expected)
+			throw formatError("Malformed tree index.");
+	}
+	if(indexed) {
+		auto index = [&](sectionKind kind) {
+			return records<uint32_t>(file, sectionOf(kind));
+		};
+		log.tree.borrow(count, index(sectionKind::treeChildOffsets),
+			index(sectionKind::treeChildren),
+			index(sectionKind::treeDepths),
+			index(sectionKind::treeEnters),
+			index(sectionKind::treeLeaves),
+			index(sectionKind::treeOrders));
+	}
+	try {
+		if(indexed) log.tree.validate(fp);
+		else log.tree.build(fp);
+	} catch(const std::invalid_argument& e) {
+		throw formatError(e.what());
+	}
+
+	log.backing = std::move(file);
+}
+
+void loadBinaryFile(const std::string& path, snailLog& log) {
+	loadBinary(mappedFile(path), log);
+}
+
+binaryLogWriter::binaryLogWriter(const std::string& path): path(path),
+		open(false), offset(0) {
+	file = std::fopen(path.c_str(), "wb");
+	if(file == nullptr) fail();
+	std::vector<char> room(sizeof(binaryHeader) +
+		directoryCapacity * sizeof(binarySection));
+	write(room.data(), room.size());
+}
+
+binaryLogWriter::~binaryLogWriter() {
+	if(file != nullptr) std::fclose(file);
+}
+
+void binaryLogWriter::fail() {
+	int error = errno;
+	throw std::system_error(error, std::system_category(),
+		"Cannot write " + path);
+}
+
+void binaryLogWriter::write(const void* data, size_t size) {
+	if(size > 0 && std::fwrite(data, 1, size, file) != size) fail();
+	offset += size;
+}
+
+void binaryLogWriter::begin(sectionKind kind) {
+	if(open) throw std::logic_error("Another section is being written.");
+	if(written(kind) || directory.size() >= directoryCapacity)
+		throw std::logic_error("The section has been written.");
+	static const char zeroes[sectionAlignment] = { 0 };
+	write(zeroes, (size_t)(align(offset) - offset));
+	binarySection section;
+	std::memset(&section, 0, sizeof(section));
+	section.kind = kind;
+	section.offset = offset;
+	directory.push_back(section);
+	open = true;
+}
+
+void binaryLogWriter::append(const void* data, size_t size, size_t count) {
+	write(data, size);
+	directory.back().size += size;
+	directory.back().count += count;
+}
+
+void binaryLogWriter::end() { open = false; }
+
+bool binaryLogWriter::written(sectionKind kind) const noexcept {
+	for(const binarySection& section : directory)
+		if(section.kind == kind) return true;
+	return false;
+}
+
+void binaryLogWriter::writeStrings(sectionKind kind,
+		const stringTable& strings) {
+	begin(kind);
+	const table<uint64_t>& offsets = strings.offsetTable();
+	append(offsets.data(), offsets.size() * sizeof(uint64_t), strings.size());
+	append(strings.charTable().data(), strings.charTable().size(), 0);
+	end();
+}
+
+void binaryLogWriter::writeLog(const snailLog& log) {
+	if(log.isLazy())
+		throw std::invalid_argument("Cannot save the log with lazy objects.");
+	stringTable meta;
+	meta.push_back(log.version);
+	meta.push_back(log.root);
+
+	// Write the sections in the order of their kinds.
+	auto strings = [&](sectionKind kind, const stringTable& t) {
+		if(!written(kind)) writeStrings(kind, t);
+	};
+	auto records = [&](sectionKind kind, const table<uint32_t>& t) {
+		if(!written(kind)) writeTable(kind, t);
+	};
+	strings(sectionKind::meta, meta);
+	strings(sectionKind::files, log.files);
+	strings(sectionKind::functions, log.functions);
+	strings(sectionKind::names, log.names.strings());
+	if(!written(sectionKind::objectNodes))
+		writeTable(sectionKind::objectNodes, log.objects.nodeTable());
+	if(!written(sectionKind::objectFields))
+		writeTable(sectionKind::objectFields, log.objects.fieldTable());
+	if(!written(sectionKind::objectHeap))
+		writeTable(sectionKind::objectHeap, log.objects.heapTable());
+	records(sectionKind::rootObjects, log.rootObjects);
+	if(!written(sectionKind::bindings))
+		writeTable(sectionKind::bindings, log.bindings);
+	records(sectionKind::footprintParents, log.footprints.parent);
+	records(sectionKind::footprintFiles, log.footprints.file);
+	records(sectionKind::footprintLines, log.footprints.line);
+	records(sectionKind::footprintFunctions, log.footprints.function);
+	records(sectionKind::footprintBindings, log.footprints.binding);
+	records(sectionKind::treeChildOffsets, log.tree.childOffsets());
+	records(sectionKind::treeChildren, log.tree.children());
+	records(sectionKind::treeDepths, log.tree.depths());
+	records(sectionKind::treeEnters, log.tree.enters());
+	records(sectionKind::treeLeaves, log.tree.leaves());
+	records(sectionKind::treeOrders, log.tree.orders());
+}
+
+void binaryLogWriter::close() {
+	if(open) throw std::logic_error("A section is being written.");
+	binaryHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+	header.byteOrder = binaryByteOrder;
+	header.version = binaryVersion;
+	header.sectionCount = (uint32_t)directory.size();
+	if(std::fseek(file, 0, SEEK_SET) != 0) fail();
+	write(&header, sizeof(header));
+	write(directory.data(), directory.size() * sizeof(binarySection));
+	FILE* closing = file;
+	file = nullptr;
+	if(std::fclose(closing) != 0) fail();
+}
+
+void saveBinaryFile(const snailLog& log, const std::string& path) {
+	binaryLogWriter writer(path);
+	writer.writeLog(log);
+	writer.close();
+}
+
+} // namespace snailviewer.
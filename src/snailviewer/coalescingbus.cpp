@@ -0,0 +1,79 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/coalescingbus.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the coalescing event bus.
+ */
+#include "snailviewer/coalescingbus.hpp"
+
+namespace snailviewer {
+
+void coalescingEventBus::subscribe(uid id, eventHandler<void*>& h) {
+	handlers.subscribe(id, h);
+}
+
+void coalescingEventBus::unsubscribe(uid id, eventHandler<void*>& h) {
+	handlers.unsubscribe(id, h);
+}
+
+void coalescingEventBus::broadcast(uid id, std::unique_ptr<eventHolder> evh) {
+	bool coalescing = evh->coalescing();
+	std::unique_ptr<eventHolder> discarded;
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	if(coalescing) {
+		size_t position = pending.size();
+		for(size_t& index : coalesced) if(pending[index].id == id) {
+			// Destroyed after unlocking, since the event may be costly
+			// to destroy.
+			discarded = std::move(pending[index].holder);
+			index = position;
+			break;
+		}
+		if(discarded == nullptr) coalesced.push_back(position);
+	}
+	pending.push_back(pendingEvent { id, std::move(evh) });
+	handlers.sampleDepth(pending.size());
+}
+
+size_t coalescingEventBus::flush() {
+	// The events left by a throwing handler are discarded.
+	flushing.clear();
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		flushing.swap(pending);
+		coalesced.clear();
+	}
+	size_t count = 0;
+	for(pendingEvent& event : flushing) if(event.holder != nullptr) {
+		handlers.dispatch(event.id, event.holder->get());
+		event.holder.reset();
+		++ count;
+	}
+	flushing.clear();
+	return count;
+}
+
+size_t coalescingEventBus::backlog() {
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	return pending.size();
+}
+
+} // namespace snailviewer.
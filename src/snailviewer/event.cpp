@@ -0,0 +1,169 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/event.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the pool of event holders.
+ *
+ * The pool is a set of slabs of fixed size slots, with the free slots
+ * linked into a lock-free stack. The head of the stack packs the index
+ * of the top slot with a tag incremented on every update, so that a
+ * slot popped and pushed back meanwhile fails the compare-and-swap
+ * (the ABA problem). The slabs are never released, so the memory of
+ * the pool is the peak number of events in flight.
+ */
+#include "snailviewer/event.hpp"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace snailviewer {
+
+// The pool of event holders.
+namespace {
+
+/// The size of the storage of a slot.
+constexpr size_t slotSize = 64;
+
+/// The slot of the pool.
+struct holderSlot {
+	/// The storage of the holder.
+	alignas(16) unsigned char storage[slotSize];
+
+	/// The index of the slot itself.
+	uint32_t index;
+
+	/// The index of the next free slot.
+	std::atomic<uint32_t> next;
+};
+
+/// The number of slots in a slab.
+constexpr uint32_t slabSize = 256;
+
+/// The maximum number of slabs.
+constexpr uint32_t maxSlabs = 4096;
+
+/// The index marking the end of the stack.
+constexpr uint32_t emptyIndex = 0xffffffffu;
+
+/// The pool of the holder slots.
+class holderPool {
+	/// The slabs allocated.
+	std::atomic<holderSlot*> slabs[maxSlabs];
+
+	/// The number of slabs allocated.
+	uint32_t slabCount;
+
+	/// The mutex serializing the allocation of slabs.
+	std::mutex growMutex;
+
+	/// The head of the free stack, with the tag in the higher 32 bits
+	/// and the index in the lower 32 bits.
+	std::atomic<uint64_t> head;
+
+	/// Retrieve the slot by its index.
+	holderSlot& at(uint32_t index) noexcept {
+		return slabs[index / slabSize].load(
+			std::memory_order_acquire)[index % slabSize];
+	}
+
+	/// Pack the head from the previous head and the new top.
+	static uint64_t pack(uint64_t previous, uint32_t top) noexcept {
+		return (((previous >> 32) + 1) << 32) | top;
+	}
+
+	/// Push the chain of slots [first, last] onto the stack.
+	void pushChain(holderSlot& first, holderSlot& last) noexcept {
+		uint64_t current = head.load(std::memory_order_relaxed);
+		do last.next.store((uint32_t)current, std::memory_order_relaxed);
+		while(!head.compare_exchange_weak(current, pack(current,
+			first.index), std::memory_order_release,
+			std::memory_order_relaxed));
+	}
+
+	/// Allocate a new slab and push its slots, unless other threads
+	/// have done so meanwhile.
+	void grow() {
+		std::lock_guard<std::mutex> lock(growMutex);
+		if((uint32_t)head.load(std::memory_order_acquire) != emptyIndex)
+			return;
+		if(slabCount == maxSlabs) throw std::bad_alloc();
+		holderSlot* slab = new holderSlot[slabSize];
+		uint32_t base = slabCount * slabSize;
+		for(uint32_t i = 0; i < slabSize; ++ i) {
+			slab[i].index = base + i;
+			slab[i].next.store(base + i + 1, std::memory_order_relaxed);
+		}
+		slabs[slabCount ++].store(slab, std::memory_order_release);
+		pushChain(slab[0], slab[slabSize - 1]);
+	}
+public:
+	/// Construct the empty pool.
+	holderPool(): slabCount(0), head(emptyIndex) {
+		for(auto& slab : slabs) slab.store(nullptr, std::memory_order_relaxed);
+	}
+
+	/// Pop a free slot, allocating slabs if there's none.
+	void* allocate() {
+		uint64_t current = head.load(std::memory_order_acquire);
+		while(true) {
+			uint32_t top = (uint32_t)current;
+			if(top == emptyIndex) {
+				grow();
+				current = head.load(std::memory_order_acquire);
+				continue;
+			}
+			holderSlot& slot = at(top);
+			uint32_t next = slot.next.load(std::memory_order_relaxed);
+			if(head.compare_exchange_weak(current, pack(current, next),
+				std::memory_order_acquire, std::memory_order_acquire))
+				return slot.storage;
+		}
+	}
+
+	/// Push the slot back onto the stack.
+	void release(void* storage) noexcept {
+		holderSlot& slot = *reinterpret_cast<holderSlot*>(storage);
+		pushChain(slot, slot);
+	}
+};
+
+/// Retrieve the pool, which is never destroyed so that the events
+/// outliving the static objects could still be released.
+holderPool& pool() {
+	static holderPool* instance = new holderPool;
+	return *instance;
+}
+
+} // Anonymous namespace.
+
+void* eventBus::eventHolder::operator new(size_t size) {
+	if(size <= slotSize) return pool().allocate();
+	return ::operator new(size);
+}
+
+void eventBus::eventHolder::operator delete(void* holder, size_t size) noexcept {
+	if(holder == nullptr) return;
+	if(size <= slotSize) pool().release(holder);
+	else ::operator delete(holder);
+}
+
+} // namespace snailviewer.
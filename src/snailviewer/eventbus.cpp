@@ -0,0 +1,200 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/eventbus.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the handler table and synchronous event bus.
+ */
+#include "snailviewer/eventbus.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <typeindex>
+#include <typeinfo>
+
+namespace snailviewer {
+
+// Helpers for the handler table.
+namespace {
+
+/// The initial number of slots.
+constexpr size_t initialSlots = 16;
+
+} // Anonymous namespace.
+
+handlerTable::handlerTable(): slots(initialSlots), used(0),
+	generation(0), dispatching(0), dirty(false), activator(nullptr) {
+	for(slot& entry : slots) entry.used = false;
+	const char* path = std::getenv(eventStatisticsVariable);
+	if(path != nullptr && *path != 0) {
+		reportPath = path;
+		instrument();
+	}
+}
+
+handlerTable::~handlerTable() {
+	if(stats == nullptr || reportPath.empty()) return;
+	try {
+		stats->dump(reportPath);
+	} catch(const std::exception&) {
+		// Nothing could be done for the report while exiting.
+	}
+}
+
+void handlerTable::instrument() {
+	if(stats == nullptr) stats.reset(new eventStatistics);
+}
+
+handlerTable::slot& handlerTable::probe(uid id) {
+	size_t mask = slots.size() - 1;
+	for(size_t i = std::hash<uid>()(id) & mask; ; i = (i + 1) & mask)
+		if(!slots[i].used || slots[i].id == id) return slots[i];
+}
+
+handlerTable::slot& handlerTable::insert(uid id) {
+	slot* entry = &probe(id);
+	if(!entry->used) {
+		// Keep the load factor under a half.
+		if((used + 1) * 2 > slots.size()) {
+			std::vector<slot> previous(slots.size() * 2);
+			previous.swap(slots);
+			for(slot& fresh : slots) fresh.used = false;
+			for(slot& moved : previous) if(moved.used) {
+				slot& target = probe(moved.id);
+				target.id = moved.id;
+				target.used = true;
+				target.activated = moved.activated;
+				target.handlers.swap(moved.handlers);
+			}
+			++ generation;
+			entry = &probe(id);
+		}
+		entry->id = id;
+		entry->used = true;
+		entry->activated = false;
+		++ used;
+	}
+	return *entry;
+}
+
+void handlerTable::subscribe(uid id, eventHandler<void*>& handler) {
+	insert(id).handlers.push_back(&handler);
+}
+
+void handlerTable::unsubscribe(uid id, eventHandler<void*>& handler) {
+	slot& entry = probe(id);
+	if(!entry.used) return;
+	auto it = std::find(entry.handlers.begin(),
+		entry.handlers.end(), &handler);
+	if(it == entry.handlers.end()) return;
+	if(dispatching > 0) {
+		*it = nullptr;
+		dirty = true;
+	} else entry.handlers.erase(it);
+}
+
+void handlerTable::compact() {
+	for(slot& entry : slots) if(entry.used)
+		entry.handlers.erase(std::remove(entry.handlers.begin(),
+			entry.handlers.end(), nullptr), entry.handlers.end());
+	dirty = false;
+}
+
+template<typename invokeType>
+void handlerTable::invoke(uid id, invokeType invoking) {
+	slot* entry = &probe(id);
+	if(activator != nullptr && !(entry->used && entry->activated)) {
+		// The slot is marked before activating, so that the events
+		// raised while activating do not activate again.
+		insert(id).activated = true;
+		activator->activate(id);
+		entry = &probe(id);
+	}
+	if(!entry->used) return;
+
+	// The handlers are indexed rather than iterated, since they might
+	// be appended while dispatching, and the slot is looked up again
+	// if the slots have been grown by the handlers.
+	struct dispatchGuard {
+		handlerTable& table;
+		dispatchGuard(handlerTable& table): table(table) { ++ table.dispatching; }
+		~dispatchGuard() {
+			if(-- table.dispatching == 0 && table.dirty) table.compact();
+		}
+	} guard(*this);
+	size_t current = generation;
+	for(size_t i = 0, n = entry->handlers.size(); i < n; ++ i) {
+		eventHandler<void*>* handler = entry->handlers[i];
+		if(handler == nullptr) continue;
+		if(stats != nullptr) {
+			typedef std::chrono::steady_clock clock;
+			std::type_index type(typeid(*handler));
+			clock::time_point start = clock::now();
+			invoking(*handler);
+			stats->handled(id, type, (uint64_t)std::chrono::duration_cast<
+				std::chrono::nanoseconds>(clock::now() - start).count());
+		} else invoking(*handler);
+		if(current != generation) {
+			entry = &probe(id);
+			current = generation;
+		}
+	}
+}
+
+void handlerTable::dispatch(uid id, const void* event) {
+	if(stats != nullptr) stats->broadcast(id);
+	invoke(id, [event](eventHandler<void*>& handler) {
+		handler.handle(event);
+	});
+}
+
+void handlerTable::dispatchBatch(uid id,
+		const void* const* events, size_t count) {
+	if(stats != nullptr) stats->broadcast(id, count);
+	invoke(id, [events, count](eventHandler<void*>& handler) {
+		handler.handleBatch(events, count);
+	});
+}
+
+size_t handlerTable::count(uid id) const {
+	size_t mask = slots.size() - 1;
+	for(size_t i = std::hash<uid>()(id) & mask; ; i = (i + 1) & mask) {
+		const slot& entry = slots[i];
+		if(!entry.used) return 0;
+		if(entry.id == id) return (size_t)std::count_if(
+			entry.handlers.begin(), entry.handlers.end(),
+			[](const eventHandler<void*>* h) { return h != nullptr; });
+	}
+}
+
+void syncEventBus::subscribe(uid id, eventHandler<void*>& h) {
+	handlers.subscribe(id, h);
+}
+
+void syncEventBus::unsubscribe(uid id, eventHandler<void*>& h) {
+	handlers.unsubscribe(id, h);
+}
+
+void syncEventBus::broadcast(uid id, std::unique_ptr<eventHolder> evh) {
+	handlers.dispatch(id, evh->get());
+}
+
+} // namespace snailviewer.
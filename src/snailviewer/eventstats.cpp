@@ -0,0 +1,239 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/eventstats.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the instrumentation of the event buses.
+ */
+#include "snailviewer/eventstats.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cxxabi.h>
+#include <system_error>
+
+namespace snailviewer {
+
+constexpr unsigned logHistogram::subBits;
+constexpr size_t logHistogram::bucketCount;
+
+size_t logHistogram::bucket(uint64_t value) noexcept {
+	constexpr uint64_t subCount = uint64_t(1) << subBits;
+	if(value < subCount) return (size_t)value;
+	unsigned shift = 63 - (unsigned)__builtin_clzll(value) - subBits;
+	return (size_t)(((uint64_t)(shift + 1) << subBits) +
+		((value >> shift) & (subCount - 1)));
+}
+
+uint64_t logHistogram::upperBound(size_t bucket) noexcept {
+	constexpr uint64_t subCount = uint64_t(1) << subBits;
+	if(bucket < subCount) return bucket;
+	unsigned shift = (unsigned)(bucket >> subBits) - 1;
+	uint64_t lower = (subCount + (bucket & (subCount - 1))) << shift;
+	return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void logHistogram::record(uint64_t value) {
+	if(buckets.empty()) buckets.resize(bucketCount, 0);
+	++ buckets[bucket(value)];
+	++ total;
+	sum += value;
+	if(value > maximum) maximum = value;
+}
+
+void logHistogram::merge(const logHistogram& other) {
+	if(other.total == 0) return;
+	if(buckets.empty()) buckets.resize(bucketCount, 0);
+	for(size_t i = 0; i < other.buckets.size(); ++ i)
+		buckets[i] += other.buckets[i];
+	total += other.total;
+	sum += other.sum;
+	maximum = std::max(maximum, other.maximum);
+}
+
+uint64_t logHistogram::quantile(double q) const noexcept {
+	if(total == 0) return 0;
+	uint64_t rank = (uint64_t)(q * (double)(total - 1)) + 1;
+	uint64_t seen = 0;
+	for(size_t i = 0; i < buckets.size(); ++ i) {
+		seen += buckets[i];
+		if(seen >= rank) return std::min(upperBound(i), maximum);
+	}
+	return maximum;
+}
+
+// Helpers for rendering the report.
+namespace {
+
+/// Render the printable characters of the uid.
+std::string uidName(const uid& id) {
+	auto append = [](std::string& out, const char* data, size_t length) {
+		for(size_t i = 0; i < length && data[i] != 0; ++ i)
+			out.push_back(data[i] >= 0x20 && data[i] < 0x7f? data[i] : '?');
+	};
+	std::string out;
+	append(out, id.module, sizeof(id.module));
+	out.push_back('.');
+	append(out, id.author, sizeof(id.author));
+	out.push_back('.');
+	append(out, id.name, sizeof(id.name));
+	return out;
+}
+
+/// Render the readable name of the type.
+std::string typeName(const std::type_index& type) {
+	int status = 0;
+	char* demangled = abi::__cxa_demangle(type.name(), nullptr, nullptr, &status);
+	if(demangled == nullptr) return type.name();
+	std::string name(demangled);
+	std::free(demangled);
+	return name;
+}
+
+/// Append the formatted text to the report.
+template<typename... argTypes>
+void appendFormat(std::string& out, const char* format, argTypes... args) {
+	char buffer[256];
+	int length = std::snprintf(buffer, sizeof(buffer), format, args...);
+	if(length > 0) out.append(buffer, std::min((size_t)length, sizeof(buffer) - 1));
+}
+
+/// Append the summary of the histogram of nanoseconds in microseconds.
+void appendLatency(std::string& out, const logHistogram& histogram) {
+	appendFormat(out, "%12llu %10.2f %10.2f %10.2f %10.2f %10.2f",
+		(unsigned long long)histogram.count(), histogram.mean() / 1e3,
+		(double)histogram.quantile(0.5) / 1e3,
+		(double)histogram.quantile(0.9) / 1e3,
+		(double)histogram.quantile(0.99) / 1e3,
+		(double)histogram.max() / 1e3);
+}
+
+} // Anonymous namespace.
+
+// Helpers for telling the statistics apart.
+namespace {
+
+/// The last serial number given to the statistics.
+std::atomic<uint64_t> serials(0);
+
+} // Anonymous namespace.
+
+eventStatistics::eventStatistics(): serial(++ serials) {}
+
+eventStatistics::shard& eventStatistics::local() {
+	// The shard used last by the thread is cached, as the thread mostly
+	// records into the statistics of a single bus.
+	static thread_local uint64_t cachedSerial = 0;
+	static thread_local shard* cachedShard = nullptr;
+	if(cachedSerial == serial) return *cachedShard;
+	std::lock_guard<std::mutex> lock(shardMutex);
+	std::unique_ptr<shard>& found = shards[std::this_thread::get_id()];
+	if(found == nullptr) found.reset(new shard);
+	cachedSerial = serial;
+	cachedShard = found.get();
+	return *found;
+}
+
+void eventStatistics::broadcast(uid id, uint64_t count) {
+	shard& own = local();
+	std::lock_guard<std::mutex> lock(own.mutex);
+	own.events[id].broadcasts += count;
+}
+
+void eventStatistics::queueDepth(size_t depth) {
+	shard& own = local();
+	std::lock_guard<std::mutex> lock(own.mutex);
+	own.depths.record(depth);
+}
+
+void eventStatistics::handled(uid id,
+		std::type_index handler, uint64_t nanos) {
+	shard& own = local();
+	std::lock_guard<std::mutex> lock(own.mutex);
+	auto& latencies = own.events[id].latencies;
+	auto it = std::find_if(latencies.begin(), latencies.end(),
+		[&handler](const std::pair<std::type_index, logHistogram>& entry) {
+			return entry.first == handler; });
+	if(it == latencies.end())
+		it = latencies.insert(it, std::make_pair(handler, logHistogram()));
+	it->second.record(nanos);
+}
+
+std::string eventStatistics::report() const {
+	// Merge the shards, ordering the events and handlers for reading.
+	struct mergedRecord {
+		uint64_t broadcasts = 0;
+		std::map<std::type_index, logHistogram> latencies;
+	};
+	std::map<uid, mergedRecord> events;
+	logHistogram depths;
+	{
+		std::lock_guard<std::mutex> lock(shardMutex);
+		for(const auto& entry : shards) {
+			shard& own = *entry.second;
+			std::lock_guard<std::mutex> shardLock(own.mutex);
+			for(const auto& event : own.events) {
+				mergedRecord& merged = events[event.first];
+				merged.broadcasts += event.second.broadcasts;
+				for(const auto& latency : event.second.latencies)
+					merged.latencies[latency.first].merge(latency.second);
+			}
+			depths.merge(own.depths);
+		}
+	}
+
+	std::string out;
+	appendFormat(out, "%-32s %12s %10s %10s %10s %10s %10s\n", "event/handler",
+		"count", "mean(us)", "p50(us)", "p90(us)", "p99(us)", "max(us)");
+	for(const auto& event : events) {
+		appendFormat(out, "%-32s %12llu\n", uidName(event.first).c_str(),
+			(unsigned long long)event.second.broadcasts);
+		for(const auto& latency : event.second.latencies) {
+			appendFormat(out, "  %-30s ", typeName(latency.first).c_str());
+			appendLatency(out, latency.second);
+			out.push_back('\n');
+		}
+	}
+	if(depths.count() > 0) appendFormat(out,
+		"queue depth: %llu samples, mean %.2f, p50 %llu, p99 %llu, max %llu\n",
+		(unsigned long long)depths.count(), depths.mean(),
+		(unsigned long long)depths.quantile(0.5),
+		(unsigned long long)depths.quantile(0.99),
+		(unsigned long long)depths.max());
+	return out;
+}
+
+void eventStatistics::dump(const std::string& path) const {
+	std::string content = report();
+	FILE* file = std::fopen(path.c_str(), "a");
+	bool written = file != nullptr && std::fwrite(content.data(), 1,
+		content.size(), file) == content.size();
+	int error = errno;
+	if(file != nullptr && std::fclose(file) != 0 && written) {
+		error = errno;
+		written = false;
+	}
+	if(!written) throw std::system_error(error,
+		std::system_category(), "Cannot write " + path);
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,206 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/footprinttree.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the footprint tree index.
+ */
+#include "snailviewer/footprinttree.hpp"
+#include "snailviewer/snaillog.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace snailviewer {
+
+void footprintTree::build(const footprintTable& footprints) {
+	size_t n = footprints.size();
+	const uint32_t* parent = footprints.parent.data();
+	if(n >= absent) throw std::invalid_argument("Too many footprints.");
+
+	// Count the children of each footprint, where the counts are then
+	// accumulated into the end of each footprint's children.
+	childOffset = table<uint32_t>();
+	childOffset.resize(n + 2);
+	uint32_t* offset = childOffset.mutableData();
+	bool ordered = true;
+	for(size_t i = 0; i < n; ++ i) {
+		uint32_t p = parent[i];
+		if(p == absent) ++ offset[n];
+		else if(p >= n) throw std::invalid_argument(
+			"The parent of the footprint is out of range.");
+		else {
+			++ offset[p];
+			if(p >= i) ordered = false;
+		}
+	}
+	for(size_t i = 1; i < n + 2; ++ i) offset[i] += offset[i - 1];
+
+	// Place the children from the last one, which leaves the offsets
+	// at the beginning of each footprint's children.
+	childList = table<uint32_t>();
+	childList.resize(n);
+	uint32_t* list = childList.mutableData();
+	for(size_t i = n; i > 0; -- i) {
+		uint32_t p = parent[i - 1];
+		list[-- offset[p == absent? n : p]] = (uint32_t)(i - 1);
+	}
+
+	depthColumn = table<uint32_t>();
+	depthColumn.resize(n);
+	enterColumn = table<uint32_t>();
+	enterColumn.resize(n);
+	leaveColumn = table<uint32_t>();
+	leaveColumn.resize(n);
+	orderColumn = table<uint32_t>();
+	orderColumn.resize(n);
+	if(ordered) buildOrdered(footprints);
+	else buildTraversal(footprints);
+}
+
+void footprintTree::buildOrdered(const footprintTable& footprints) {
+	size_t n = footprints.size();
+	const uint32_t* parent = footprints.parent.data();
+	uint32_t* depth = depthColumn.mutableData();
+	uint32_t* enter = enterColumn.mutableData();
+	uint32_t* leave = leaveColumn.mutableData();
+	uint32_t* order = orderColumn.mutableData();
+
+	// Accumulate the subtree sizes from the descendants to the roots,
+	// which are kept in the leave column for now.
+	for(size_t i = 0; i < n; ++ i) leave[i] = 1;
+	for(size_t i = n; i > 0; -- i) {
+		uint32_t p = parent[i - 1];
+		if(p != absent) leave[p] += leave[i - 1];
+	}
+
+	// Number the footprints from the roots to the descendants, where
+	// each footprint's next free number for its children is kept.
+	std::vector<uint32_t> cursor(n);
+	uint32_t rootCursor = 0;
+	for(size_t i = 0; i < n; ++ i) {
+		uint32_t p = parent[i];
+		uint32_t& next = p == absent? rootCursor : cursor[p];
+		depth[i] = p == absent? 0 : depth[p] + 1;
+		enter[i] = next;
+		next += leave[i];
+		leave[i] += enter[i];
+		cursor[i] = enter[i] + 1;
+		order[enter[i]] = (uint32_t)i;
+	}
+}
+
+void footprintTree::buildTraversal(const footprintTable& footprints) {
+	size_t n = footprints.size();
+	uint32_t* depth = depthColumn.mutableData();
+	uint32_t* enter = enterColumn.mutableData();
+	uint32_t* leave = leaveColumn.mutableData();
+	uint32_t* order = orderColumn.mutableData();
+	const uint32_t* offset = childOffset.data();
+	const uint32_t* list = childList.data();
+
+	// Traverse from the virtual root, keeping the footprints being
+	// visited with the position of their next child.
+	std::vector<std::pair<size_t, uint32_t>> stack;
+	stack.push_back(std::make_pair(n, offset[n]));
+	uint32_t number = 0;
+	while(!stack.empty()) {
+		std::pair<size_t, uint32_t>& top = stack.back();
+		if(top.second == offset[top.first + 1]) {
+			if(top.first != n) leave[top.first] = number;
+			stack.pop_back();
+			continue;
+		}
+		uint32_t child = list[top.second ++];
+		depth[child] = (uint32_t)(stack.size() - 1);
+		enter[child] = number;
+		order[number ++] = child;
+		stack.push_back(std::make_pair((size_t)child, offset[child]));
+	}
+
+	// The footprints not reachable from roots are inside cycles.
+	if(number != n) throw std::invalid_argument(
+		"The parents of the footprints form a cycle.");
+}
+
+void footprintTree::validate(const footprintTable& footprints) const {
+	size_t n = footprints.size();
+	const uint32_t* parent = footprints.parent.data();
+	if(childOffset.size() != n + 2 || childList.size() != n ||
+		depthColumn.size() != n || enterColumn.size() != n ||
+		leaveColumn.size() != n || orderColumn.size() != n)
+		throw std::invalid_argument("The index is of another size.");
+	if(childOffset[0] != 0 || childOffset[n + 1] != n)
+		throw std::invalid_argument("The children are malformed.");
+
+	// Each footprint is listed in ascending order under its parent, so
+	// the list is a permutation. The children take the consecutive
+	// pre-order numbers after their parent, each past the subtree of
+	// the previous child, and the subtree of the parent ends right past
+	// the last child. So the numbers strictly grow from parents to
+	// children, which rules out cycles, and are distinct by the order.
+	for(size_t s = 0; s <= n; ++ s) {
+		uint32_t first = childOffset[s], last = childOffset[s + 1];
+		if(first > last || last > n)
+			throw std::invalid_argument("The children are malformed.");
+		uint32_t expectedParent = s == n? absent : (uint32_t)s;
+		uint64_t next = s == n? 0 : (uint64_t)enterColumn[s] + 1;
+		uint64_t depth = s == n? 0 : (uint64_t)depthColumn[s] + 1;
+		for(uint32_t k = first; k < last; ++ k) {
+			uint32_t c = childList[k];
+			if(c >= n || parent[c] != expectedParent ||
+				(k > first && childList[k - 1] >= c))
+				throw std::invalid_argument("The children are malformed.");
+			if(next >= n || enterColumn[c] != next || leaveColumn[c] <= next ||
+				orderColumn[enterColumn[c]] != c || depthColumn[c] != depth)
+				throw std::invalid_argument("The pre-order is malformed.");
+			next = leaveColumn[c];
+		}
+		if(next != (s == n? (uint64_t)n : (uint64_t)leaveColumn[s]))
+			throw std::invalid_argument("The pre-order is malformed.");
+	}
+}
+
+uint32_t footprintTree::nextSibling(uint32_t i) const {
+	// The footprint right after the subtree is either the next sibling,
+	// or some ancestor's sibling which is shallower.
+	uint32_t after = leaveColumn[i];
+	if(after >= size()) return absent;
+	uint32_t next = orderColumn[after];
+	return depthColumn[next] == depthColumn[i]? next : absent;
+}
+
+uint32_t footprintTree::previousSibling(uint32_t i, uint32_t parent) const {
+	const uint32_t* first = childBegin(parent);
+	const uint32_t* at = std::lower_bound(first, childEnd(parent), i);
+	return at == first? absent : *(at - 1);
+}
+
+uint32_t footprintTree::stepOver(uint32_t i) const {
+	uint32_t after = leaveColumn[i];
+	return after < size()? orderColumn[after] : absent;
+}
+
+uint32_t footprintTree::stepOut(uint32_t parent) const {
+	return parent == absent? absent : stepOver(parent);
+}
+
+} // namespace snailviewer.
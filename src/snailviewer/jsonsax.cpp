@@ -0,0 +1,336 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/jsonsax.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the event driven JSON parser.
+ *
+ * The parser is a hand written state machine instead of a recursive
+ * descent one, the nesting of compound values is kept in a stack.
+ */
+#include "snailviewer/jsonsax.hpp"
+#include "snailviewer/jsonscan.hpp"
+#include <cstring>
+
+namespace snailviewer {
+
+jsonError::jsonError(const std::string& message, size_t offset):
+	std::runtime_error(message + " (at offset " +
+		std::to_string(offset) + ")"), errorOffset(offset) {}
+
+// Helper functions used by the parser.
+namespace {
+
+/// Whether the character is a JSON whitespace.
+inline bool isSpace(char c) noexcept {
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/// Skip the whitespaces from the current position.
+inline const char* skipSpace(const char* p, const char* end) noexcept {
+	while(p < end && isSpace(*p)) ++ p;
+	return p;
+}
+
+/// Raise the error at specified position.
+[[noreturn]] void fail(const char* what, const char* at, const char* begin) {
+	throw jsonError(what, (size_t)(at - begin));
+}
+
+/// Find the end of string token starting at the quote, returning the
+/// pointer right past the closing quote. The escaped flag is set when
+/// there's escape sequence inside.
+const char* scanString(const char* at, const char* begin,
+		const char* end, bool& escaped) {
+	const char* p = at + 1;
+	escaped = false;
+	while(true) {
+		// Jump to the next quote, and check whether there's a backslash
+		// before it, which is far more rare than the quotes.
+		const char* q = (const char*)std::memchr(p, '"', end - p);
+		if(q == nullptr) fail("Unterminated string", at, begin);
+		const char* b = (const char*)std::memchr(p, '\\', q - p);
+		if(b == nullptr) return q + 1;
+		escaped = true;
+		if(b + 1 >= end) fail("Unterminated string", at, begin);
+		p = b + 2;
+	}
+}
+
+/// Find the end of a number token, validating its grammar.
+const char* scanNumber(const char* at, const char* begin, const char* end) {
+	const char* p = at;
+	if(p < end && *p == '-') ++ p;
+	if(p >= end || *p < '0' || *p > '9') fail("Malformed number", at, begin);
+	if(*p == '0') ++ p;
+	else while(p < end && *p >= '0' && *p <= '9') ++ p;
+	if(p < end && *p == '.') {
+		++ p;
+		if(p >= end || *p < '0' || *p > '9')
+			fail("Malformed number", at, begin);
+		while(p < end && *p >= '0' && *p <= '9') ++ p;
+	}
+	if(p < end && (*p == 'e' || *p == 'E')) {
+		++ p;
+		if(p < end && (*p == '+' || *p == '-')) ++ p;
+		if(p >= end || *p < '0' || *p > '9')
+			fail("Malformed number", at, begin);
+		while(p < end && *p >= '0' && *p <= '9') ++ p;
+	}
+	return p;
+}
+
+/// Match a keyword literal like true, false or null.
+const char* scanKeyword(const char* at, const char* begin,
+		const char* end, const char* word) {
+	size_t length = std::strlen(word);
+	if((size_t)(end - at) < length || std::memcmp(at, word, length) != 0)
+		fail("Unexpected character", at, begin);
+	return at + length;
+}
+
+/// Append the code point as UTF-8 into the output.
+void appendUtf8(std::string& out, unsigned long cp) {
+	if(cp < 0x80) out.push_back((char)cp);
+	else if(cp < 0x800) {
+		out.push_back((char)(0xc0 | (cp >> 6)));
+		out.push_back((char)(0x80 | (cp & 0x3f)));
+	} else if(cp < 0x10000) {
+		out.push_back((char)(0xe0 | (cp >> 12)));
+		out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+		out.push_back((char)(0x80 | (cp & 0x3f)));
+	} else {
+		out.push_back((char)(0xf0 | (cp >> 18)));
+		out.push_back((char)(0x80 | ((cp >> 12) & 0x3f)));
+		out.push_back((char)(0x80 | ((cp >> 6) & 0x3f)));
+		out.push_back((char)(0x80 | (cp & 0x3f)));
+	}
+}
+
+/// Parse four hexadecimal digits, returning false if malformed.
+bool parseHex4(const char* p, const char* end, unsigned long& cp) {
+	if(end - p < 4) return false;
+	cp = 0;
+	for(int i = 0; i < 4; ++ i) {
+		char c = p[i]; cp <<= 4;
+		if(c >= '0' && c <= '9') cp |= (unsigned long)(c - '0');
+		else if(c >= 'a' && c <= 'f') cp |= (unsigned long)(c - 'a' + 10);
+		else if(c >= 'A' && c <= 'F') cp |= (unsigned long)(c - 'A' + 10);
+		else return false;
+	}
+	return true;
+}
+
+} // Anonymous namespace.
+
+const char* jsonSkip(const char* at, const char* begin, const char* end) {
+	const char* p = skipSpace(at, end);
+	if(p >= end) fail("Unexpected end of text", p, begin);
+	bool escaped;
+	switch(*p) {
+	case '"': return scanString(p, begin, end, escaped);
+	case 't': return scanKeyword(p, begin, end, "true");
+	case 'f': return scanKeyword(p, begin, end, "false");
+	case 'n': return scanKeyword(p, begin, end, "null");
+	case '{': case '[': break;
+	default: return scanNumber(p, begin, end);
+	}
+
+	// Skip the compound value with only the nesting tracked. The blocks
+	// closing fewer brackets than the depth cannot end the value, so
+	// only their brackets are counted.
+	size_t depth = 0;
+	jsonScanner scanner(p, end);
+	jsonBlock block;
+	while(scanner.next(block)) {
+		size_t closes = (size_t)__builtin_popcountll(block.closes);
+		if(closes < depth) {
+			depth += (size_t)__builtin_popcountll(block.opens);
+			depth -= closes;
+			continue;
+		}
+		for(uint64_t brackets = block.opens | block.closes;
+				brackets != 0; brackets &= brackets - 1) {
+			unsigned bit = (unsigned)__builtin_ctzll(brackets);
+			if(block.opens >> bit & 1) ++ depth;
+			else if(-- depth == 0) return block.begin + bit + 1;
+		}
+	}
+	fail("Unterminated compound value", p, begin);
+}
+
+const char* jsonHandler::skip(const char* at,
+		const char* origin, const char* end) {
+	return jsonSkip(at, origin, end);
+}
+
+void jsonUnescape(const char* begin, const char* end, std::string& out) {
+	out.clear();
+	const char* p = begin + 1;
+	const char* last = end - 1;
+	while(p < last) {
+		const char* b = (const char*)std::memchr(p, '\\', last - p);
+		if(b == nullptr) { out.append(p, last - p); break; }
+		out.append(p, b - p);
+		if(b + 1 >= last) break;
+		p = b + 2;
+		switch(b[1]) {
+		case 'b': out.push_back('\b'); break;
+		case 'f': out.push_back('\f'); break;
+		case 'n': out.push_back('\n'); break;
+		case 'r': out.push_back('\r'); break;
+		case 't': out.push_back('\t'); break;
+		case 'u': {
+			unsigned long cp;
+			if(!parseHex4(p, last, cp)) { out.push_back('?'); break; }
+			p += 4;
+
+			// Combine the surrogate pairs if there's any.
+			unsigned long low;
+			if(cp >= 0xd800 && cp < 0xdc00 && last - p >= 6 &&
+				p[0] == '\\' && p[1] == 'u' && parseHex4(p + 2, last, low)
+				&& low >= 0xdc00 && low < 0xe000) {
+				cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+				p += 6;
+			}
+			appendUtf8(out, cp);
+		} break;
+		default: out.push_back(b[1]); break;
+		}
+	}
+}
+
+bool jsonToUint32(const char* begin, const char* end, uint32_t& out) noexcept {
+	if(begin >= end) return false;
+	uint64_t value = 0;
+	for(const char* p = begin; p < end; ++ p) {
+		if(*p < '0' || *p > '9') return false;
+		value = value * 10 + (uint64_t)(*p - '0');
+		if(value > 0xffffffffull) return false;
+	}
+	out = (uint32_t)value;
+	return true;
+}
+
+void jsonParser::parse(const char* begin, const char* end,
+		jsonHandler& handler, const char* origin) {
+	nesting.clear();
+	const char* p = begin;
+	if(origin == nullptr) origin = begin;
+	bool escaped;
+
+	// The parser alternates between expecting a value and expecting
+	// what follows a value, the keys are consumed before the values.
+	while(true) {
+		// Parse a value at current position.
+		p = skipSpace(p, end);
+		if(p >= end) fail("Unexpected end of text", p, origin);
+		const char* q;
+		switch(*p) {
+		case '{':
+			if(handler.beginObject(p) == jsonAction::skip) {
+				q = handler.skip(p, origin, end);
+				handler.endObject(q);
+				p = q; break;
+			}
+			q = skipSpace(p + 1, end);
+			if(q < end && *q == '}') {
+				handler.endObject(q + 1);
+				p = q + 1; break;
+			}
+			nesting.push_back('{');
+			p = q; goto parseKey;
+		case '[':
+			if(handler.beginArray(p) == jsonAction::skip) {
+				q = handler.skip(p, origin, end);
+				handler.endArray(q);
+				p = q; break;
+			}
+			q = skipSpace(p + 1, end);
+			if(q < end && *q == ']') {
+				handler.endArray(q + 1);
+				p = q + 1; break;
+			}
+			nesting.push_back('[');
+			p = q; continue;
+		case '"':
+			q = scanString(p, origin, end, escaped);
+			handler.scalar(jsonType::string, p, q);
+			p = q; break;
+		case 't':
+			q = scanKeyword(p, origin, end, "true");
+			handler.scalar(jsonType::boolean, p, q);
+			p = q; break;
+		case 'f':
+			q = scanKeyword(p, origin, end, "false");
+			handler.scalar(jsonType::boolean, p, q);
+			p = q; break;
+		case 'n':
+			q = scanKeyword(p, origin, end, "null");
+			handler.scalar(jsonType::null, p, q);
+			p = q; break;
+		default:
+			q = scanNumber(p, origin, end);
+			handler.scalar(jsonType::number, p, q);
+			p = q; break;
+		}
+
+		// Consume what follows a value, which might close several
+		// compound values at once.
+		while(true) {
+			p = skipSpace(p, end);
+			if(nesting.empty()) {
+				if(p != end) fail("Unexpected trailing text", p, origin);
+				return;
+			}
+			if(p >= end) fail("Unexpected end of text", p, origin);
+			char top = nesting.back();
+			if(*p == ',') {
+				p = skipSpace(p + 1, end);
+				if(top == '{') goto parseKey;
+				else goto nextValue;
+			} else if(*p == '}' && top == '{') {
+				nesting.pop_back();
+				handler.endObject(++ p);
+			} else if(*p == ']' && top == '[') {
+				nesting.pop_back();
+				handler.endArray(++ p);
+			} else fail("Unexpected character", p, origin);
+		}
+
+	parseKey:
+		// Parse the key and colon of an object member.
+		if(p >= end || *p != '"') fail("Expecting member name", p, origin);
+		{
+			const char* q = scanString(p, origin, end, escaped);
+			if(escaped) {
+				jsonUnescape(p, q, scratch);
+				handler.key(scratch.data(), scratch.size());
+			} else handler.key(p + 1, (size_t)(q - p - 2));
+			p = skipSpace(q, end);
+		}
+		if(p >= end || *p != ':') fail("Expecting colon", p, origin);
+		++ p;
+	nextValue:
+		continue;
+	}
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,202 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/jsonscan.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the vectorized JSON scanner.
+ */
+#include "snailviewer/jsonscan.hpp"
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SNAIL_SCAN_X86 1
+#endif
+
+namespace snailviewer {
+
+// The classifiers and the bit manipulations.
+namespace {
+
+/// The characters of interest in a block of 64 bytes.
+struct rawBlock {
+	uint64_t quotes;
+	uint64_t backslashes;
+	uint64_t opens;
+	uint64_t closes;
+	uint64_t commas;
+};
+
+/// The classifier of a block of 64 bytes.
+typedef void (*classifierType)(const char* data, rawBlock& raw);
+
+/// Classify the block byte by byte.
+void classifyScalar(const char* data, rawBlock& raw) {
+	std::memset(&raw, 0, sizeof(raw));
+	for(unsigned i = 0; i < 64; ++ i) {
+		uint64_t bit = uint64_t(1) << i;
+		switch(data[i]) {
+		case '"': raw.quotes |= bit; break;
+		case '\\': raw.backslashes |= bit; break;
+		case '{': case '[': raw.opens |= bit; break;
+		case '}': case ']': raw.closes |= bit; break;
+		case ',': raw.commas |= bit; break;
+		default: break;
+		}
+	}
+}
+
+#ifdef SNAIL_SCAN_X86
+// The brackets differ from their square counterparts only by the bit
+// 0x20, so each kind of brackets is matched by a single comparison
+// after setting that bit.
+
+/// Classify the block 16 bytes at a time.
+__attribute__((target("sse2")))
+void classifySse(const char* data, rawBlock& raw) {
+	const __m128i quote = _mm_set1_epi8('"');
+	const __m128i backslash = _mm_set1_epi8('\\');
+	const __m128i open = _mm_set1_epi8('{');
+	const __m128i close = _mm_set1_epi8('}');
+	const __m128i comma = _mm_set1_epi8(',');
+	const __m128i fold = _mm_set1_epi8(0x20);
+	std::memset(&raw, 0, sizeof(raw));
+	for(unsigned i = 0; i < 64; i += 16) {
+		__m128i chars = _mm_loadu_si128((const __m128i*)(data + i));
+		__m128i folded = _mm_or_si128(chars, fold);
+		raw.quotes |= uint64_t((uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(chars, quote))) << i;
+		raw.backslashes |= uint64_t((uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(chars, backslash))) << i;
+		raw.opens |= uint64_t((uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(folded, open))) << i;
+		raw.closes |= uint64_t((uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(folded, close))) << i;
+		raw.commas |= uint64_t((uint16_t)_mm_movemask_epi8(
+			_mm_cmpeq_epi8(chars, comma))) << i;
+	}
+}
+
+/// Classify the block 32 bytes at a time.
+__attribute__((target("avx2")))
+void classifyAvx2(const char* data, rawBlock& raw) {
+	const __m256i quote = _mm256_set1_epi8('"');
+	const __m256i backslash = _mm256_set1_epi8('\\');
+	const __m256i open = _mm256_set1_epi8('{');
+	const __m256i close = _mm256_set1_epi8('}');
+	const __m256i comma = _mm256_set1_epi8(',');
+	const __m256i fold = _mm256_set1_epi8(0x20);
+	std::memset(&raw, 0, sizeof(raw));
+	for(unsigned i = 0; i < 64; i += 32) {
+		__m256i chars = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i folded = _mm256_or_si256(chars, fold);
+		raw.quotes |= uint64_t((uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(chars, quote))) << i;
+		raw.backslashes |= uint64_t((uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(chars, backslash))) << i;
+		raw.opens |= uint64_t((uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(folded, open))) << i;
+		raw.closes |= uint64_t((uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(folded, close))) << i;
+		raw.commas |= uint64_t((uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(chars, comma))) << i;
+	}
+}
+#endif
+
+/// The chosen classifier and its name.
+struct classifierChoice {
+	classifierType classify;
+	const char* name;
+};
+
+/// Choose the best classifier supported by the processor.
+classifierChoice chooseClassifier() noexcept {
+#ifdef SNAIL_SCAN_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return classifierChoice { classifyAvx2, "avx2" };
+	if(__builtin_cpu_supports("sse2"))
+		return classifierChoice { classifySse, "sse" };
+#endif
+	return classifierChoice { classifyScalar, "scalar" };
+}
+
+/// The classifier used by the scanners.
+const classifierChoice classifier = chooseClassifier();
+
+/// Find the characters escaped by backslashes. A backslash escapes the
+/// next character unless it is escaped itself, so only the characters
+/// after odd-length runs of backslashes are escaped.
+inline uint64_t findEscaped(uint64_t backslashes, uint64_t& carry) noexcept {
+	const uint64_t evenBits = 0x5555555555555555ull;
+	backslashes &= ~carry;
+	uint64_t followsEscape = (backslashes << 1) | carry;
+	uint64_t oddStarts = backslashes & ~evenBits & ~followsEscape;
+	uint64_t evenStarts = oddStarts + backslashes;
+	carry = evenStarts < oddStarts? 1 : 0;
+	uint64_t invert = evenStarts << 1;
+	return (evenBits ^ invert) & followsEscape;
+}
+
+/// Compute the prefix XOR of the bits, where the i-th bit of the result
+/// is the XOR of the bits [0, i] of the input.
+inline uint64_t prefixXor(uint64_t bits) noexcept {
+	bits ^= bits << 1;
+	bits ^= bits << 2;
+	bits ^= bits << 4;
+	bits ^= bits << 8;
+	bits ^= bits << 16;
+	bits ^= bits << 32;
+	return bits;
+}
+
+} // Anonymous namespace.
+
+bool jsonScanner::next(jsonBlock& block) {
+	if(position >= end) return false;
+
+	// Classify the block, padding the last one with whitespaces.
+	rawBlock raw;
+	size_t remaining = (size_t)(end - position);
+	if(remaining >= 64) classifier.classify(position, raw);
+	else {
+		char padded[64];
+		std::memset(padded, ' ', sizeof(padded));
+		std::memcpy(padded, position, remaining);
+		classifier.classify(padded, raw);
+	}
+
+	// The bytes inside strings are the ones between an unescaped opening
+	// quote (inclusive) and its closing quote (exclusive).
+	uint64_t quotes = raw.quotes & ~findEscaped(raw.backslashes, escapedCarry);
+	uint64_t inString = prefixXor(quotes) ^ stringCarry;
+	stringCarry = (uint64_t)((int64_t)inString >> 63);
+
+	block.begin = position;
+	block.opens = raw.opens & ~inString;
+	block.closes = raw.closes & ~inString;
+	block.commas = raw.commas & ~inString;
+	position += 64;
+	return true;
+}
+
+const char* jsonScanLevel() noexcept { return classifier.name; }
+
+} // namespace snailviewer.
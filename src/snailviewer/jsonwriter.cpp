@@ -0,0 +1,206 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/jsonwriter.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the JSON writer.
+ */
+#include "snailviewer/jsonwriter.hpp"
+
+namespace snailviewer {
+
+void jsonQuote(const char* data, size_t length, std::string& out) {
+	static const char hex[] = "0123456789abcdef";
+	out.push_back('"');
+	for(size_t i = 0; i < length; ++ i) {
+		unsigned char c = (unsigned char)data[i];
+		switch(c) {
+		case '"': out.append("\\\""); break;
+		case '\\': out.append("\\\\"); break;
+		case '\b': out.append("\\b"); break;
+		case '\f': out.append("\\f"); break;
+		case '\n': out.append("\\n"); break;
+		case '\r': out.append("\\r"); break;
+		case '\t': out.append("\\t"); break;
+		default:
+			if(c < 0x20) {
+				out.append("\\u00");
+				out.push_back(hex[c >> 4]);
+				out.push_back(hex[c & 0xf]);
+			} else out.push_back((char)c);
+		}
+	}
+	out.push_back('"');
+}
+
+// Helpers for rendering the entities.
+namespace {
+
+/// Append the name of the symbol as a JSON string.
+void quoteName(const symbolTable& names, uint32_t symbol, std::string& out) {
+	jsonQuote(names.data(symbol), names.length(symbol), out);
+}
+
+/// Append the string table as a JSON array.
+void quoteStrings(const stringTable& strings, std::string& out) {
+	out.push_back('[');
+	for(size_t i = 0; i < strings.size(); ++ i) {
+		if(i > 0) out.push_back(',');
+		jsonQuote(strings.data((uint32_t)i),
+			strings.length((uint32_t)i), out);
+	}
+	out.push_back(']');
+}
+
+} // Anonymous namespace.
+
+jsonWriter::jsonWriter(const snailLog& log): log(log),
+	rootIndex(log.objects.size(), absent) {
+	for(size_t i = log.rootObjects.size(); i > 0; -- i)
+		rootIndex[log.rootObjects[i - 1]] = (uint32_t)(i - 1);
+}
+
+void jsonWriter::object(uint32_t id, bool allowReference, std::string& out) const {
+	// The stack of struct objects being rendered, with the index of the
+	// field to render next.
+	struct pending { uint32_t id; uint32_t field; };
+	std::vector<pending> stack;
+
+	while(true) {
+		if(allowReference && rootIndex[id] != absent) {
+			out.append(std::to_string(rootIndex[id]));
+		} else {
+			const objectNode& node = log.objects[id];
+			out.append(node.trait == objectTrait::structure?
+				"{\"trait\":\"struct\"" : "{\"trait\":\"literal\"");
+			if(node.type != absent) {
+				out.append(",\"type\":");
+				quoteName(log.names, node.type, out);
+			}
+			out.append(",\"data\":");
+			if(node.trait == objectTrait::structure) {
+				out.push_back('{');
+				stack.push_back(pending { id, 0 });
+			} else {
+				out.append(log.objects.literalData(node), node.count);
+				out.push_back('}');
+			}
+		}
+		allowReference = true;
+
+		// Find the next field to render, closing the finished structs.
+		while(!stack.empty()) {
+			pending& top = stack.back();
+			const objectNode& node = log.objects[top.id];
+			if(top.field < node.count) {
+				const objectField& field =
+					log.objects.fields(node)[top.field];
+				if(top.field ++ > 0) out.push_back(',');
+				quoteName(log.names, field.name, out);
+				out.push_back(':');
+				id = field.object;
+				break;
+			}
+			out.append("}}");
+			stack.pop_back();
+		}
+		if(stack.empty()) return;
+	}
+}
+
+void jsonWriter::prologue(std::string& out) const {
+	out.append("{\"version\":");
+	jsonQuote(log.version.data(), log.version.size(), out);
+	if(!log.root.empty()) {
+		out.append(",\"root\":");
+		jsonQuote(log.root.data(), log.root.size(), out);
+	}
+	out.append(",\"files\":");
+	quoteStrings(log.files, out);
+	out.append(",\"functions\":");
+	quoteStrings(log.functions, out);
+	out.append(",\"objects\":[");
+}
+
+void jsonWriter::interlude(std::string& out) const {
+	out.append("],\"footprints\":[");
+}
+
+void jsonWriter::epilogue(std::string& out) const {
+	out.append("]}\n");
+}
+
+void jsonWriter::rootObjects(size_t begin, size_t end, std::string& out) const {
+	for(size_t i = begin; i < end; ++ i) {
+		if(i > 0) out.push_back(',');
+		object(log.rootObjects[i], false, out);
+	}
+}
+
+void jsonWriter::footprints(size_t begin, size_t end, std::string& out) const {
+	const footprintTable& fp = log.footprints;
+	for(size_t i = begin; i < end; ++ i) {
+		uint32_t bindingBegin = fp.bindingBegin((uint32_t)i);
+		uint32_t bindingEnd = fp.bindingEnd((uint32_t)i);
+		out.append(i > 0? ",{" : "{");
+		const char* separator = "";
+		auto index = [&](const char* key, uint32_t value) {
+			if(value == absent) return;
+			out.append(separator);
+			out.append(key);
+			out.append(std::to_string(value));
+			separator = ",";
+		};
+		index("\"parent\":", fp.parent[i]);
+		index("\"file\":", fp.file[i]);
+		index("\"line\":", fp.line[i]);
+		index("\"function\":", fp.function[i]);
+		out.append(separator);
+		out.append("\"objects\":{");
+
+		// The bindings of the same scope are grouped together, in the
+		// order that the scopes first appear.
+		for(uint32_t b = bindingBegin; b < bindingEnd; ++ b) {
+			uint32_t scope = log.bindings[b].scope;
+			bool seen = false;
+			for(uint32_t p = bindingBegin; p < b && !seen; ++ p)
+				seen = log.bindings[p].scope == scope;
+			if(seen) continue;
+
+			if(b > bindingBegin) out.push_back(',');
+			quoteName(log.names, scope, out);
+			out.append(":{");
+			bool first = true;
+			for(uint32_t q = b; q < bindingEnd; ++ q) {
+				const objectBinding& binding = log.bindings[q];
+				if(binding.scope != scope) continue;
+				if(!first) out.push_back(',');
+				first = false;
+				quoteName(log.names, binding.name, out);
+				out.push_back(':');
+				object(binding.object, true, out);
+			}
+			out.push_back('}');
+		}
+		out.append("}}");
+	}
+}
+
+} // namespace snailviewer.
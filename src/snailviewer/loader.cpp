@@ -0,0 +1,1040 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/loader.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the snail log loader.
+ *
+ * The loader is a handler of the JSON parser, keeping a stack of frames
+ * telling which entity it is inside. Each frame knows how to interpret
+ * the members, and how to hand its product over to the enclosing frame
+ * when it ends.
+ */
+#include "snailviewer/loader.hpp"
+#include "snailviewer/binary.hpp"
+#include "snailviewer/jsonscan.hpp"
+#include "snailviewer/mapping.hpp"
+#include "snailviewer/threadpool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
+
+namespace snailviewer {
+
+// The loader handler and its helpers.
+namespace {
+
+/// The flag marking an object id as an unresolved reference to the
+/// root "objects" array, which might appear after the footprints.
+constexpr uint32_t rootReference = 0x80000000u;
+
+/// The kind of entity that a frame is inside.
+enum class frameKind : char {
+	/// Expecting the root entity.
+	document = 0,
+
+	/// Inside the root entity.
+	root,
+
+	/// Inside the "files" array.
+	files,
+
+	/// Inside the "functions" array.
+	functions,
+
+	/// Inside the root "objects" array.
+	objects,
+
+	/// Inside the "footprints" array.
+	footprints,
+
+	/// Inside a footprint entity.
+	footprint,
+
+	/// Inside the "objects" of a footprint, keyed by scopes.
+	scopes,
+
+	/// Inside a scope of a footprint, keyed by object names.
+	bindings,
+
+	/// Inside an object entity.
+	entity,
+
+	/// Expecting the "data" of struct object parsed afterwards.
+	deferred,
+
+	/// Inside the "data" of a struct object, keyed by field names.
+	fields,
+};
+
+/// The frame of the loader's stack.
+struct frame {
+	/// The kind of the frame.
+	frameKind kind;
+
+	/// Whether the trait is struct, only meaningful for entity.
+	bool isStruct;
+
+	/// Whether the fields has been collected, for entity.
+	bool collected;
+
+	/// The name that the product will be bound or assigned to. For
+	/// bindings frame it is the scope.
+	uint32_t name;
+
+	/// The type of the object, for entity.
+	uint32_t type;
+
+	/// The index of the first collected field in the scratch, for entity.
+	size_t fieldBase;
+
+	/// The raw text of the data of object entity.
+	const char* dataBegin;
+	const char* dataEnd;
+
+	/// Construct the frame of specified kind.
+	frame(frameKind kind, uint32_t name = absent): kind(kind),
+		isStruct(false), collected(false), name(name), type(absent),
+		fieldBase(0), dataBegin(nullptr), dataEnd(nullptr) {}
+};
+
+/// The handler filling the snail log.
+class jsonLoader : public jsonHandler {
+	/// The log being filled.
+	snailLog& log;
+
+	/// The beginning of the whole text, for locating errors.
+	const char* text;
+
+	/// The frames of the loader.
+	std::vector<frame> frames;
+
+	/// The fields collected for the structs being parsed.
+	std::vector<objectField> scratch;
+
+	/// The key of the member whose value is being parsed.
+	const char* keyName;
+	size_t keyLength;
+
+	/// The beginning of the compound value being skipped, or null.
+	const char* skipBegin;
+
+	/// Whether the objects of footprints are skipped and recorded.
+	bool lazy;
+
+	/// The text of the "footprints" array, which is loaded in chunks
+	/// once it is found.
+	textRange footprintText;
+
+	/// The buffer for decoding strings.
+	std::string decoded;
+
+	/// Raise the error at specified position.
+	[[noreturn]] void fail(const char* what, const char* at) {
+		throw jsonError(what, (size_t)(at - text));
+	}
+
+	/// Whether the current key equals to the specified name.
+	bool keyIs(const char* name) const noexcept {
+		size_t length = std::strlen(name);
+		return keyLength == length &&
+			std::memcmp(keyName, name, length) == 0;
+	}
+
+	/// Reject the members of the root entity after the footprints,
+	/// which are loaded before the rest of the text is parsed.
+	void expectLast(const char* at) {
+		if(footprintText.begin != nullptr && (keyIs("version") ||
+			keyIs("root") || keyIs("files") || keyIs("functions") ||
+			keyIs("objects") || keyIs("footprints")))
+			fail("Expecting footprints to be the last member", at);
+	}
+
+	/// Intern the current key as a name.
+	uint32_t keyAsName() { return log.names.intern(keyName, keyLength); }
+
+	/// Decode the string token into the decoded buffer.
+	const std::string& decode(const char* begin, const char* end) {
+		jsonUnescape(begin, end, decoded);
+		return decoded;
+	}
+
+	/// Parse the number token as an index, null is treated as absent.
+	uint32_t index(jsonType type, const char* begin, const char* end) {
+		uint32_t value;
+		if(type == jsonType::null) return absent;
+		if(type != jsonType::number || !jsonToUint32(begin, end, value)
+			|| value == absent) fail("Expecting an index", begin);
+		return value;
+	}
+
+	/// Hand over the product object to the enclosing frame.
+	void deliver(uint32_t object, uint32_t name) {
+		frame& top = frames.back();
+		switch(top.kind) {
+		case frameKind::objects:
+			log.rootObjects.push_back(object);
+			break;
+		case frameKind::bindings: {
+			objectBinding binding;
+			binding.scope = top.name;
+			binding.name = name;
+			binding.object = object;
+			log.bindings.push_back(binding);
+		} break;
+		case frameKind::fields: {
+			objectField field;
+			field.name = name;
+			field.object = object;
+			scratch.push_back(field);
+		} break;
+		default: break;
+		}
+	}
+
+	/// Finish the object entity on the top of the stack.
+	void finishEntity() {
+		frame entity = frames.back();
+		frames.pop_back();
+
+		uint32_t object;
+		if(entity.isStruct) {
+			// The data is parsed afterwards when the trait is known.
+			if(!entity.collected && entity.dataBegin != nullptr) {
+				entity.fieldBase = scratch.size();
+				frames.push_back(frame(frameKind::deferred));
+				jsonParser parser;
+				parser.parse(entity.dataBegin, entity.dataEnd, *this, text);
+				frames.pop_back();
+			}
+			size_t count = scratch.size() - entity.fieldBase;
+			object = log.objects.addStruct(entity.type,
+				scratch.data() + entity.fieldBase, count);
+			scratch.resize(entity.fieldBase);
+		} else {
+			const char* data = entity.dataBegin;
+			size_t length = (size_t)(entity.dataEnd - entity.dataBegin);
+			if(data == nullptr) { data = "null"; length = 4; }
+			object = log.objects.addLiteral(entity.type, data, length);
+		}
+		if(object >= rootReference) fail("Too many objects", text);
+		deliver(object, entity.name);
+	}
+
+	/// A scalar value is placed where an object is expected.
+	void scalarObject(jsonType type, const char* begin, const char* end) {
+		uint32_t name = frames.back().kind == frameKind::objects?
+			absent : keyAsName();
+
+		// Numbers refers to root objects except inside root objects.
+		uint32_t value;
+		if(type == jsonType::number && frames.back().kind !=
+			frameKind::objects && jsonToUint32(begin, end, value)
+			&& value < rootReference) {
+			deliver(value | rootReference, name);
+			return;
+		}
+
+		// Otherwise they are treated as untyped literals.
+		deliver(log.objects.addLiteral(absent,
+			begin, (size_t)(end - begin)), name);
+	}
+
+	/// Decide how to handle a compound value, given whether it is an
+	/// array or an object.
+	jsonAction compound(bool isArray, const char* at) {
+		frame& top = frames.back();
+		frameKind next = frameKind::document;
+		uint32_t name = absent;
+		switch(top.kind) {
+		case frameKind::document:
+			if(isArray) fail("Expecting root entity", at);
+			next = frameKind::root;
+			break;
+		case frameKind::root:
+			expectLast(at);
+			if(!isArray) break;
+			if(keyIs("files")) next = frameKind::files;
+			else if(keyIs("functions")) next = frameKind::functions;
+			else if(keyIs("objects")) next = frameKind::objects;
+			else if(keyIs("footprints")) footprintText.begin = at;
+			break;
+		case frameKind::files:
+		case frameKind::functions:
+			fail("Expecting string", at);
+		case frameKind::objects:
+		case frameKind::bindings:
+		case frameKind::fields:
+			if(isArray) fail("Expecting object entity", at);
+			if(top.kind != frameKind::objects) name = keyAsName();
+			next = frameKind::entity;
+			break;
+		case frameKind::footprints: {
+			if(isArray) fail("Expecting footprint entity", at);
+			if(log.footprints.size() >= absent) fail("Too many footprints", at);
+			log.footprints.push_back(absent, absent, absent, absent,
+				(uint32_t)log.bindings.size());
+			if(lazy) log.objectTexts.push_back(textRange { nullptr, nullptr });
+			next = frameKind::footprint;
+		} break;
+		case frameKind::footprint:
+			if(isArray || !keyIs("objects")) break;
+			if(lazy) log.objectTexts.mutableBack().begin = at;
+			else next = frameKind::scopes;
+			break;
+		case frameKind::scopes:
+			if(isArray) break;
+			name = keyAsName();
+			next = frameKind::bindings;
+			break;
+		case frameKind::entity:
+			if(!keyIs("data")) break;
+			if(!isArray && top.isStruct) {
+				top.fieldBase = scratch.size();
+				next = frameKind::fields;
+			} else top.dataBegin = at;
+			break;
+		case frameKind::deferred:
+			if(isArray) fail("Expecting struct fields", at);
+			next = frameKind::fields;
+			break;
+		}
+
+		// Skip the values that are of no interest or parsed afterwards.
+		if(next == frameKind::document) {
+			skipBegin = at;
+			return jsonAction::skip;
+		}
+		frames.push_back(frame(next, name));
+		return jsonAction::descend;
+	}
+
+	/// Finish a compound value, given the pointer right past it.
+	void finish(const char* past) {
+		// The skipped value might be the raw data of object entity, or
+		// the objects of footprint loaded lazily.
+		if(skipBegin != nullptr) {
+			frame& top = frames.back();
+			if(top.kind == frameKind::entity && top.dataBegin == skipBegin)
+				top.dataEnd = past;
+			else if(top.kind == frameKind::footprint && lazy &&
+				log.objectTexts.back().begin == skipBegin)
+				log.objectTexts.mutableBack().end = past;
+			else if(top.kind == frameKind::root &&
+				footprintText.begin == skipBegin)
+				footprintText.end = past;
+			skipBegin = nullptr;
+			return;
+		}
+
+		frameKind kind = frames.back().kind;
+		if(kind == frameKind::entity) { finishEntity(); return; }
+		frames.pop_back();
+		switch(kind) {
+		case frameKind::footprint:
+			log.footprints.binding.mutableBack() = (uint32_t)log.bindings.size();
+			break;
+		case frameKind::fields:
+			if(frames.back().kind == frameKind::entity)
+				frames.back().collected = true;
+			break;
+		default: break;
+		}
+	}
+public:
+	/// Load the "footprints" array at the position once it is found,
+	/// returning the pointer right past it, or empty for skipping it.
+	std::function<const char*(const char*)> footprintsFound;
+
+	/// Construct the loader filling the log, given the kind of entity
+	/// that the parsed text is inside.
+	jsonLoader(snailLog& log, const char* text, bool lazy,
+		frameKind start = frameKind::document): log(log), text(text),
+		keyName(nullptr), keyLength(0), skipBegin(nullptr), lazy(lazy) {
+		footprintText.begin = footprintText.end = nullptr;
+		frames.push_back(frame(start));
+	}
+
+	/// Construct the loader filling the bindings of a footprint from
+	/// the text of its objects.
+	jsonLoader(snailLog& log, const textRange& objects): log(log),
+		text(objects.begin), keyName("objects"), keyLength(7),
+		skipBegin(nullptr), lazy(false) {
+		footprintText.begin = footprintText.end = nullptr;
+		frames.push_back(frame(frameKind::footprint));
+	}
+
+	/// Retrieve the text of the "footprints" array, or null if absent.
+	const textRange& footprints() const noexcept { return footprintText; }
+
+	/// Resolve the references to the root objects after loading, given
+	/// the number of root objects and the function mapping the index
+	/// of root object to the object id.
+	template<typename resolverType>
+	void resolve(const char* end, size_t count, resolverType resolver) {
+		auto resolveOne = [&](uint32_t& object) {
+			if(object < rootReference) return;
+			uint32_t index = object & ~rootReference;
+			if(index >= count) fail("Object index out of range", end);
+			object = resolver(index);
+		};
+		objectBinding* bindings = log.bindings.mutableData();
+		for(size_t i = 0; i < log.bindings.size(); ++ i)
+			resolveOne(bindings[i].object);
+		objectField* fields = log.objects.mutableFields();
+		for(size_t i = 0; i < log.objects.fieldCount(); ++ i)
+			resolveOne(fields[i].object);
+	}
+
+	/// Validate the references of footprints after loading.
+	void validate(const char* end) {
+		auto check = [&](const table<uint32_t>& column,
+				size_t count, const char* what) {
+			for(uint32_t value : column)
+				if(value != absent && value >= count) fail(what, end);
+		};
+		check(log.footprints.parent, log.footprints.size(),
+			"Parent index out of range");
+		check(log.footprints.file, log.files.size(),
+			"File index out of range");
+		check(log.footprints.function, log.functions.size(),
+			"Function index out of range");
+	}
+
+	virtual jsonAction beginObject(const char* at) override {
+		return compound(false, at);
+	}
+
+	virtual void endObject(const char* past) override { finish(past); }
+
+	virtual jsonAction beginArray(const char* at) override {
+		return compound(true, at);
+	}
+
+	virtual void endArray(const char* past) override { finish(past); }
+
+	virtual const char* skip(const char* at,
+			const char* origin, const char* end) override {
+		if(at == footprintText.begin && footprintsFound)
+			return footprintsFound(at);
+		return jsonSkip(at, origin, end);
+	}
+
+	virtual void key(const char* name, size_t length) override {
+		keyName = name;
+		keyLength = length;
+	}
+
+	virtual void scalar(jsonType type, const char* begin,
+			const char* end) override {
+		frame& top = frames.back();
+		switch(top.kind) {
+		case frameKind::document:
+			fail("Expecting root entity", begin);
+		case frameKind::root:
+			expectLast(begin);
+			if(type != jsonType::string) break;
+			if(keyIs("version")) log.version = decode(begin, end);
+			else if(keyIs("root")) log.root = decode(begin, end);
+			break;
+		case frameKind::files:
+		case frameKind::functions:
+			if(type != jsonType::string) fail("Expecting string", begin);
+			(top.kind == frameKind::files? log.files : log.functions)
+				.push_back(decode(begin, end));
+			break;
+		case frameKind::footprints:
+			fail("Expecting footprint entity", begin);
+		case frameKind::footprint: {
+			footprintTable& fp = log.footprints;
+			if(keyIs("parent")) fp.parent.mutableBack() = index(type, begin, end);
+			else if(keyIs("file")) fp.file.mutableBack() = index(type, begin, end);
+			else if(keyIs("line")) fp.line.mutableBack() = index(type, begin, end);
+			else if(keyIs("function"))
+				fp.function.mutableBack() = index(type, begin, end);
+		} break;
+		case frameKind::objects:
+		case frameKind::bindings:
+		case frameKind::fields:
+			scalarObject(type, begin, end);
+			break;
+		case frameKind::entity:
+			if(keyIs("data")) {
+				top.dataBegin = begin;
+				top.dataEnd = end;
+			} else if(type == jsonType::string) {
+				if(keyIs("trait")) top.isStruct = decode(begin, end) == "struct";
+				else if(keyIs("type")) {
+					const std::string& name = decode(begin, end);
+					top.type = log.names.intern(name.data(), name.size());
+				}
+			}
+			break;
+		case frameKind::deferred:
+			fail("Expecting struct fields", begin);
+		default: break;
+		}
+	}
+};
+
+} // Anonymous namespace.
+
+// Helpers for loading the footprints in chunks.
+namespace {
+
+/// The number of bytes of footprints in a chunk.
+constexpr size_t chunkBytes = size_t(1) << 20;
+
+/// The number of chunks in flight per worker.
+constexpr size_t chunksPerWorker = 4;
+
+/// The consecutive footprints parsed by a task.
+struct footprintChunk {
+	/// The beginning of the first footprint.
+	const char* begin;
+
+	/// The separator right after the last footprint.
+	const char* end;
+
+	/// The number of footprints.
+	size_t count;
+};
+
+/// Skip the whitespaces.
+inline const char* skipSpace(const char* p, const char* end) noexcept {
+	while(p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) ++ p;
+	return p;
+}
+
+/// Locate the footprints in the "footprints" array and group them into
+/// chunks one after another, by finding the commas right inside the
+/// array with the structural scanner.
+class footprintSplitter {
+	/// The beginning of the whole text, for locating errors.
+	const char* text;
+
+	/// The beginning of the array.
+	const char* array;
+
+	/// The scanner through the array and the block being split.
+	jsonScanner scanner;
+	jsonBlock block;
+
+	/// The brackets and commas of the block yet to split.
+	uint64_t marks;
+
+	/// The nesting depth at the marks yet to split.
+	size_t depth;
+
+	/// The chunk being grouped.
+	footprintChunk chunk;
+
+	/// The pointer right past the array, or null before it ends.
+	const char* past;
+public:
+	/// Construct the splitter of the array at the position.
+	footprintSplitter(const char* text, const char* at, const char* end):
+		text(text), array(at), scanner(at, end), marks(0), depth(0),
+		past(nullptr) {
+		block.begin = at;
+		block.opens = block.closes = block.commas = 0;
+		chunk.begin = skipSpace(at + 1, end);
+		chunk.end = nullptr;
+		chunk.count = 0;
+		if(chunk.begin < end && *chunk.begin == ']') past = chunk.begin + 1;
+	}
+
+	/// The pointer right past the array, once it is split through.
+	const char* end() const noexcept { return past; }
+
+	/// Locate the next chunk, or return false once the array ends.
+	bool next(footprintChunk& result) {
+		while(past == nullptr) {
+			if(marks == 0) {
+				if(!scanner.next(block)) throw jsonError(
+					"Unterminated compound value", (size_t)(array - text));
+
+				// The commas right inside the array are at depth 1, which
+				// is unreachable if the block closes too few brackets.
+				size_t closes = (size_t)__builtin_popcountll(block.closes);
+				if(depth > 1 && closes + 1 < depth) {
+					depth += (size_t)__builtin_popcountll(block.opens);
+					depth -= closes;
+					continue;
+				}
+				marks = block.opens | block.closes | block.commas;
+				continue;
+			}
+
+			unsigned bit = (unsigned)__builtin_ctzll(marks);
+			marks &= marks - 1;
+			const char* at = block.begin + bit;
+			if(block.opens >> bit & 1) ++ depth;
+			else if(block.closes >> bit & 1) {
+				if(-- depth > 0) continue;
+				past = at + 1;
+				chunk.end = at;
+				++ chunk.count;
+				result = chunk;
+				return true;
+			} else if(depth == 1) {
+				chunk.end = at;
+				++ chunk.count;
+				if((size_t)(at - chunk.begin) >= chunkBytes) {
+					result = chunk;
+					chunk.begin = at + 1;
+					chunk.count = 0;
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+};
+
+/// Parse the footprints of the chunk into the log.
+void parseChunk(snailLog& log, const char* text,
+		const footprintChunk& chunk, bool lazy) {
+	jsonLoader loader(log, text, lazy, frameKind::footprints);
+	jsonParser parser;
+	const char* p = chunk.begin;
+	for(size_t i = 0; i < chunk.count; ++ i) {
+		const char* q = jsonSkip(p, text, chunk.end);
+		parser.parse(p, q, loader, text);
+		p = skipSpace(q, chunk.end);
+		if(i + 1 < chunk.count? *p != ',' : p != chunk.end)
+			throw jsonError("Unexpected character", (size_t)(p - text));
+		++ p;
+	}
+}
+
+/// Append the footprints parsed into a separate log, translating the
+/// symbols and objects local to the separate log, and resolving the
+/// references to the root objects. The bindings are handed to the
+/// consumer if any, after the consumed ones. The offset of the chunk
+/// is for reporting errors.
+void mergeChunk(snailLog& log, const snailLog& part, size_t offset,
+		bindingConsumer* consumer, size_t& consumed) {
+	std::vector<uint32_t> symbols(part.names.size());
+	for(size_t i = 0; i < symbols.size(); ++ i)
+		symbols[i] = log.names.intern(part.names.data((uint32_t)i),
+			part.names.length((uint32_t)i));
+	auto symbol = [&](uint32_t s) { return s == absent? absent : symbols[s]; };
+
+	// The objects are added in the order that the fields precede their
+	// structs, so they are translated in order as well.
+	std::vector<uint32_t> objects(part.objects.size());
+	auto object = [&](uint32_t o) {
+		if(o < rootReference) return objects[o];
+		uint32_t index = o & ~rootReference;
+		if(index >= log.rootObjects.size())
+			throw jsonError("Object index out of range", offset);
+		return log.rootObjects[index];
+	};
+	std::vector<objectField> fields;
+	for(size_t i = 0; i < objects.size(); ++ i) {
+		const objectNode& node = part.objects[(uint32_t)i];
+		if(node.trait == objectTrait::structure) {
+			const objectField* source = part.objects.fields(node);
+			fields.resize(node.count);
+			for(uint32_t j = 0; j < node.count; ++ j) {
+				fields[j].name = symbol(source[j].name);
+				fields[j].object = object(source[j].object);
+			}
+			objects[i] = log.objects.addStruct(symbol(node.type),
+				fields.data(), node.count);
+		} else objects[i] = log.objects.addLiteral(symbol(node.type),
+			part.objects.literalData(node), node.count);
+		if(objects[i] >= rootReference)
+			throw jsonError("Too many objects", offset);
+	}
+
+	size_t base = consumed + log.bindings.size();
+	std::vector<objectBinding> bindings;
+	for(const objectBinding& binding : part.bindings) {
+		objectBinding translated;
+		translated.scope = symbol(binding.scope);
+		translated.name = symbol(binding.name);
+		translated.object = object(binding.object);
+		if(consumer != nullptr) bindings.push_back(translated);
+		else log.bindings.push_back(translated);
+	}
+	if(consumer != nullptr && !bindings.empty()) {
+		consumer->consume(bindings.data(), bindings.size());
+		consumed += bindings.size();
+	}
+
+	const footprintTable& fp = part.footprints;
+	if(log.footprints.size() + fp.size() >= absent)
+		throw jsonError("Too many footprints", offset);
+	for(uint32_t i = 0; i < fp.size(); ++ i) {
+		uint64_t end = base + fp.bindingEnd(i);
+		if(end >= absent) throw jsonError("Too many bindings", offset);
+		log.footprints.push_back(fp.parent[i], fp.file[i], fp.line[i],
+			fp.function[i], (uint32_t)end);
+	}
+	log.objectTexts.append(part.objectTexts.begin(), part.objectTexts.end());
+}
+
+/// Reserve the footprint tables for the footprints to load, so that
+/// the loaded ones are never moved while appending.
+void reserveFootprints(snailLog& log, size_t count, bool lazy) {
+	footprintTable& fp = log.footprints;
+	fp.parent.reserve(count);
+	fp.file.reserve(count);
+	fp.line.reserve(count);
+	fp.function.reserve(count);
+	fp.binding.reserve(count + 1);
+	if(lazy) log.objectTexts.reserve(count);
+}
+
+/// Notify the observer of the footprints appended since the last time.
+void notifyLoaded(const snailLog& log, size_t& notified,
+		const loadOptions& options) {
+	size_t count = log.footprints.size();
+	if(options.observer != nullptr && count > notified)
+		options.observer->loaded(log, (uint32_t)notified, (uint32_t)count);
+	notified = count;
+}
+
+/// Load the footprints of the "footprints" array at the position, which
+/// are split into chunks and parsed on a thread pool if the array is
+/// large, while the chunks parsed are merged in order. Returns the
+/// pointer right past the array.
+const char* loadFootprints(const char* text, const char* at,
+		const char* end, snailLog& log, const loadOptions& options) {
+	// The number of footprints is unknown until the array is split
+	// through, so the tables are reserved for the most footprints the
+	// text could hold, each taking at least "{}" and a comma.
+	bool lazy = options.lazyObjects;
+	reserveFootprints(log, std::min<size_t>(
+		(size_t)(end - at) / 3 + 1, absent), lazy);
+	if(options.observer != nullptr)
+		options.observer->opened(log, unknownFootprints, lazy);
+
+	// The consumed bindings are merged from separate logs as well, so
+	// that the footprints refer to them after the consumed ones.
+	bindingConsumer* consumer = lazy? nullptr : options.bindings;
+	size_t notified = 0, consumed = 0;
+	footprintSplitter splitter(text, at, end);
+	footprintChunk chunk;
+	std::unique_ptr<threadPool> pool;
+	if(options.threads != 1 && (size_t)(end - at) > chunkBytes)
+		pool.reset(new threadPool(options.threads));
+	if(pool == nullptr) {
+		while(splitter.next(chunk)) {
+			if(consumer == nullptr) parseChunk(log, text, chunk, lazy);
+			else {
+				snailLog part;
+				parseChunk(part, text, chunk, lazy);
+				mergeChunk(log, part, (size_t)(chunk.begin - text),
+					consumer, consumed);
+			}
+			notifyLoaded(log, notified, options);
+		}
+		return splitter.end();
+	}
+
+	// The chunks are parsed as soon as they are split, and merged as
+	// soon as the chunks before them are merged.
+	struct pendingChunk {
+		size_t offset;
+		std::future<std::unique_ptr<snailLog>> part;
+	};
+	std::deque<pendingChunk> inflight;
+	size_t window = pool->size() * chunksPerWorker;
+	bool splitting = true;
+	while(true) {
+		if(splitting && inflight.size() < window &&
+				(splitting = splitter.next(chunk))) {
+			inflight.push_back(pendingChunk { (size_t)(chunk.begin - text),
+				pool->submit([=]() {
+					std::unique_ptr<snailLog> part(new snailLog);
+					parseChunk(*part, text, chunk, lazy);
+					return part;
+				}) });
+		}
+		if(inflight.empty()) break;
+
+		// Merge the earliest chunk once parsed, or wait for it when no
+		// more chunk could be split.
+		pendingChunk& front = inflight.front();
+		if(splitting && inflight.size() < window && front.part.wait_for(
+			std::chrono::seconds(0)) != std::future_status::ready) continue;
+		std::unique_ptr<snailLog> part = front.part.get();
+		mergeChunk(log, *part, front.offset, consumer, consumed);
+		inflight.pop_front();
+		notifyLoaded(log, notified, options);
+	}
+	return splitter.end();
+}
+
+} // Anonymous namespace.
+
+// Helpers for decoding the objects lazily.
+namespace {
+
+/// Copies the objects from the log into the decoded objects.
+///
+/// The root objects might refer to each other in cycles, which are
+/// copied by referring to the structs being copied with placeholders,
+/// and rewriting the placeholders once the structs are copied. The
+/// placeholders are references beyond the root objects, so they never
+/// match the copied structs with the references of the decoded text.
+class objectCopier {
+	/// The log to copy from.
+	const snailLog& from;
+
+	/// The log to copy into.
+	snailLog& to;
+
+	/// The map from the copied object ids to the new ones, where the
+	/// structs being copied are mapped to absent.
+	std::unordered_map<uint32_t, uint32_t> copied;
+
+	/// The placeholders of the structs being copied and referred to.
+	std::unordered_map<uint32_t, uint32_t> placeholders;
+
+	/// The next placeholder to allocate.
+	uint32_t nextPlaceholder;
+
+	/// The copied structs referring to some placeholders.
+	std::vector<uint32_t> unresolved;
+
+	/// The fields collected for the structs being copied.
+	std::vector<objectField> scratch;
+
+	/// Translate the symbol of the name.
+	uint32_t name(uint32_t symbol) {
+		if(symbol == absent) return absent;
+		return to.names.intern(from.names.data(symbol),
+			from.names.length(symbol));
+	}
+
+	/// Retrieve the placeholder of the struct being copied.
+	uint32_t placeholder(uint32_t id) {
+		auto it = placeholders.find(id);
+		if(it != placeholders.end()) return it->second;
+		if(nextPlaceholder == absent)
+			throw jsonError("Too many objects", 0);
+		return placeholders[id] = nextPlaceholder ++;
+	}
+
+	/// Rewrite the placeholder of the struct once it is copied.
+	void resolve(uint32_t id, uint32_t object) {
+		auto it = placeholders.find(id);
+		if(it == placeholders.end()) return;
+		uint32_t value = it->second;
+		placeholders.erase(it);
+		objectField* fields = to.objects.mutableFields();
+		size_t kept = 0;
+		for(uint32_t referrer : unresolved) {
+			const objectNode& node = to.objects[referrer];
+			bool pending = false;
+			for(uint32_t i = 0; i < node.count; ++ i) {
+				uint32_t& field = fields[node.begin + i].object;
+				if(field == value) field = object;
+				else if(field >= rootReference) pending = true;
+			}
+			if(pending) unresolved[kept ++] = referrer;
+		}
+		unresolved.resize(kept);
+	}
+public:
+	/// Construct the copier between the logs.
+	objectCopier(const snailLog& from, snailLog& to): from(from), to(to),
+		nextPlaceholder(rootReference | (uint32_t)from.rootObjects.size()) {}
+
+	/// Copy the object and the objects inside it, returning its new id.
+	uint32_t copy(uint32_t id) {
+		// The stack of structs being copied, with the next field to copy
+		// and the index of their first field in the scratch.
+		struct pending { uint32_t id; uint32_t field; size_t base; };
+		std::vector<pending> stack;
+		uint32_t result = absent;
+
+		// Copy the literal or enter the struct, returning whether the
+		// result is available.
+		auto enter = [&](uint32_t id) {
+			auto it = copied.find(id);
+			if(it != copied.end()) {
+				result = it->second == absent? placeholder(id) : it->second;
+				return true;
+			}
+			const objectNode& node = from.objects[id];
+			if(node.trait == objectTrait::structure) {
+				copied.emplace(id, absent);
+				stack.push_back(pending { id, 0, scratch.size() });
+				return false;
+			}
+			result = to.objects.addLiteral(name(node.type),
+				from.objects.literalData(node), node.count);
+			copied.emplace(id, result);
+			return true;
+		};
+
+		enter(id);
+		while(!stack.empty()) {
+			pending& top = stack.back();
+			const objectNode& node = from.objects[top.id];
+			if(top.field < node.count) {
+				const objectField& field =
+					from.objects.fields(node)[top.field ++];
+				scratch.push_back(objectField { name(field.name), absent });
+				if(enter(field.object)) scratch.back().object = result;
+				continue;
+			}
+			const objectField* fields = scratch.data() + top.base;
+			result = to.objects.addStruct(name(node.type), fields, node.count);
+			if(std::any_of(fields, fields + node.count,
+				[](const objectField& field) {
+					return field.object >= rootReference; }))
+				unresolved.push_back(result);
+			copied[top.id] = result;
+			resolve(top.id, result);
+			scratch.resize(top.base);
+			stack.pop_back();
+			if(!stack.empty()) scratch.back().object = result;
+		}
+		return result;
+	}
+};
+
+} // Anonymous namespace.
+
+void loadJson(const char* begin, const char* end, snailLog& log,
+		const loadOptions& options) {
+	jsonLoader loader(log, begin, options.lazyObjects);
+	auto resolveRoots = [&]() {
+		loader.resolve(end, log.rootObjects.size(),
+			[&log](uint32_t index) { return log.rootObjects[index]; });
+	};
+
+	// The tables before the footprints are complete once they are
+	// found, and released of their over-allocated memory, since they
+	// could be read by observers while the footprints are loading. So
+	// are the root objects, which refer to each other and are resolved
+	// first.
+	auto complete = [&]() {
+		resolveRoots();
+		log.files.shrink();
+		log.functions.shrink();
+		log.rootObjects.shrink();
+		if(options.lazyObjects) {
+			log.names.shrink();
+			log.objects.shrink();
+		}
+	};
+	loader.footprintsFound = [&](const char* at) {
+		complete();
+		return loadFootprints(begin, at, end, log, options);
+	};
+	jsonParser parser;
+	parser.parse(begin, end, loader);
+	if(loader.footprints().begin == nullptr) {
+		complete();
+		if(options.observer != nullptr)
+			options.observer->opened(log, 0, options.lazyObjects);
+	}
+
+	// The objects of footprints loaded eagerly might still refer to the
+	// root objects, where they are parsed into the log directly.
+	if(!options.lazyObjects) {
+		resolveRoots();
+		log.names.shrink();
+		log.objects.shrink();
+		log.bindings.shrink();
+	}
+	loader.validate(end);
+	try {
+		log.tree.build(log.footprints);
+	} catch(const std::invalid_argument& e) {
+		throw jsonError(e.what(), (size_t)(end - begin));
+	}
+}
+
+void loadJsonFile(const std::string& path, snailLog& log,
+		const loadOptions& options) {
+	mappedFile file(path);
+	loadJson(file.data(), file.end(), log, options);
+	if(log.isLazy()) log.backing = std::move(file);
+}
+
+void loadFile(const std::string& path, snailLog& log,
+		const loadOptions& options) {
+	mappedFile file(path);
+	if(isBinaryLog(file.data(), file.size())) {
+		loadBinary(std::move(file), log);
+		if(options.observer != nullptr) {
+			size_t count = log.footprints.size();
+			options.observer->opened(log, count, false);
+			if(count > 0) options.observer->loaded(log, 0, (uint32_t)count);
+		}
+	} else {
+		loadJson(file.data(), file.end(), log, options);
+		if(log.isLazy()) log.backing = std::move(file);
+	}
+}
+
+void decodeObjects(const snailLog& log, uint32_t footprint,
+		decodedObjects& decoded) {
+	if(footprint >= log.objectTexts.size())
+		throw jsonError("The objects are not loaded lazily", 0);
+	snailLog scratch;
+	const textRange& range = log.objectTexts[footprint];
+	if(range.begin != nullptr) {
+		jsonLoader loader(scratch, range);
+		jsonParser parser;
+		parser.parse(range.begin, range.end, loader);
+
+		// Copy the referred root objects before resolving, since the
+		// fields are rewritten in place while resolving.
+		std::unordered_map<uint32_t, uint32_t> roots;
+		auto collect = [&](uint32_t object) {
+			uint32_t index = object & ~rootReference;
+			if(object >= rootReference && index < log.rootObjects.size())
+				roots.emplace(index, absent);
+		};
+		for(const objectBinding& binding : scratch.bindings)
+			collect(binding.object);
+		for(const objectField& field : scratch.objects.fieldTable())
+			collect(field.object);
+		objectCopier copier(log, scratch);
+		for(auto& root : roots)
+			root.second = copier.copy(log.rootObjects[root.first]);
+		loader.resolve(range.end, log.rootObjects.size(),
+			[&roots](uint32_t index) { return roots[index]; });
+	}
+	scratch.names.shrink();
+	scratch.objects.shrink();
+	scratch.bindings.shrink();
+	decoded.names = std::move(scratch.names);
+	decoded.objects = std::move(scratch.objects);
+	decoded.bindings = std::move(scratch.bindings);
+}
+
+} // namespace snailviewer.
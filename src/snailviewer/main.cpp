@@ -24,10 +24,501 @@
  *
  * This file aggregates the modules in snail viewer and provides an
  * entry point to launch and view snail logs.
+ *
+ * The log is loaded on a background thread, and the footprints are
+ * browsable as soon as they are loaded, while the rest of the log is
+ * still loading. The objects of JSON logs are loaded lazily, so that
+ * they could be decoded for the loaded footprints while loading.
+ *
+ * The searches scan the footprints loaded when they start, and the
+ * viewer jumps to the first hit as soon as it is found.
+ *
+ * The modules in the directory named by SNAIL_MODULES are loaded at
+ * startup, and initialized when their events are first dispatched or
+ * their widgets are first shown in place of the object pane.
  */
+#define NCURSES_NOMACROS
+#include "snailviewer/backgroundloader.hpp"
+#include "snailviewer/eventstats.hpp"
+#include "snailviewer/objectpane.hpp"
+#include "snailviewer/prioritybus.hpp"
+#include "snailviewer/registry.hpp"
+#include "snailviewer/search.hpp"
+#include "snailviewer/sourcepane.hpp"
+#include "snailviewer/widget.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <regex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <curses.h>
+
+using namespace snailviewer;
+
+// Helpers for the viewer.
+namespace {
+
+/// The timeout of reading keys while loading, in milliseconds.
+constexpr int loadingTimeout = 50;
+
+/// Print the usage of the viewer.
+void usage(const char* program) {
+	std::fprintf(stderr,
+		"Usage: %s [-j <threads>] <log>\n"
+		"View a snail log of either JSON or binary format.\n"
+		"\n"
+		"  -j <threads>  number of loading threads (default: all cores)\n"
+		"\n"
+		"Keys:\n"
+		"  n, p, right, left  next or previous footprint\n"
+		"  g, G               first or last loaded footprint\n"
+		"  u                  parent footprint\n"
+		"  j, k, down, up     move between the objects\n"
+		"  space, enter       expand or collapse the object\n"
+		"  page up, page down scroll the source code\n"
+		"  /                  search the loaded footprints, e.g.\n"
+		"                     /function~^main$ local:x==42 p.y==0 text\n"
+		"  ], [               next or previous hit of the search\n"
+		"  w                  switch between the object pane and the\n"
+		"                     widgets of the modules\n"
+		"  F12                append the event statistics to the file\n"
+		"                     named by %s\n"
+		"  q                  quit\n"
+		"\n"
+		"The modules in the directory named by %s are loaded.\n",
+		program, eventStatisticsVariable, moduleDirectoryVariable);
+}
+
+/// The bar showing the state of the viewer on a single row.
+class statusBar : public widget {
+	/// The text shown.
+	std::string text;
+protected:
+	virtual void paint(cursesWindow* window, const rect& area) override {
+		std::string row = text;
+		row.resize((size_t)width(), ' ');
+		wattron(window, A_REVERSE);
+		mvwaddnstr(window, 0, area.left, row.c_str() + area.left, area.width);
+		wattroff(window, A_REVERSE);
+	}
+public:
+	/// The uid of the status bar.
+	static constexpr uid barId() {
+		return makeUid(uidType::widget, "SNAIL", "HL", "STATUS");
+	}
+
+	/// Construct the empty status bar.
+	statusBar(): widget(barId()) {}
+
+	/// Change the text shown.
+	void show(const std::string& value) {
+		if(value == text) return;
+		text = value;
+		invalidate();
+	}
+};
+
+/// The viewer reacting to the loading and the keys.
+class viewer : private eventHandler<logOpenedEvent>,
+	private eventHandler<footprintsLoadedEvent>,
+	private eventHandler<logLoadedEvent>,
+	private eventHandler<searchHitsEvent> {
+	/// The bus of the viewer.
+	priorityEventBus& bus;
+
+	/// The log being viewed.
+	const snailLog& log;
+
+	/// The path of the log.
+	std::string path;
+
+	/// The caches of the source files and decoded objects.
+	sourceCache sources;
+	objectCache objects;
+
+	/// The widgets of the viewer.
+	sourcePane sourceView;
+	objectPane objectView;
+	statusBar status;
+
+	/// The registry of the modules, and the facilities provided to them.
+	moduleRegistry& modules;
+	moduleContext context;
+
+	/// The widgets declared by the modules, which are created when they
+	/// are first shown.
+	std::vector<uid> widgetIds;
+	std::vector<std::unique_ptr<widget>> moduleWidgets;
+
+	/// The widget shown in place of the object pane, or 0 for the object
+	/// pane, otherwise the index of the module widget plus 1.
+	size_t shownPane;
+
+	/// The display where the widgets are placed, or null.
+	display* screen;
+
+	/// The number of footprints loaded and to load, where the latter
+	/// might be unknownFootprints.
+	size_t loaded, total;
+
+	/// Whether the objects of footprints are decoded lazily, known once
+	/// the log is opened.
+	bool lazy;
+
+	/// Whether the loading is finished.
+	bool finished;
+
+	/// The message of the last action or error.
+	std::string message;
+
+	/// The current footprint, or absent before any is loaded.
+	uint32_t current;
+
+	/// The engine of the searches.
+	searchEngine search;
+
+	/// The generation of the search shown, or 0 for none.
+	uint64_t searchGeneration;
+
+	/// Whether the search has jumped to its first hit.
+	bool searchJumped;
+
+	/// Whether the search shown is yet to report its last hits.
+	bool searching;
+
+	/// Whether the query is being typed, and the query typed.
+	bool prompting;
+	std::string query;
+
+	/// Update the status bar.
+	void updateStatus() {
+		std::string text = " " + path;
+		if(current != absent) text += "  #" + std::to_string(current);
+		text += "  " + std::to_string(loaded);
+		if(total != unknownFootprints) text += "/" + std::to_string(total);
+		if(!finished) text += " loading";
+		if(searchGeneration != 0) {
+			text += "  " + std::to_string(search.hits()) + " hits";
+			if(!search.finished())
+				text += " (" + std::to_string(search.scanned()) + " scanned)";
+		}
+		if(!message.empty()) text += "  " + message;
+		if(prompting) text = "/" + query;
+		status.show(text);
+	}
+
+	/// Show the footprint if it is loaded.
+	void select(uint32_t footprint) {
+		if(footprint >= loaded || footprint == current) return;
+		current = footprint;
+		const footprintTable& fp = log.footprints;
+		uint32_t file = fp.file[footprint];
+		if(file != absent && file >= log.files.size()) file = absent;
+		sourceView.show(file, fp.line[footprint]);
+		objectView.show(footprint);
+		message.clear();
+		updateStatus();
+	}
+
+	/// Retrieve the readable name of the module widget.
+	std::string widgetName(size_t index) const {
+		const moduleComponent* component = modules.find(widgetIds[index]);
+		return component != nullptr && component->name != nullptr?
+			component->name : "widget";
+	}
+
+	/// Retrieve the widget of the module, creating it on first use, or
+	/// null if the module fails to create it.
+	widget* moduleWidget(size_t index) {
+		if(moduleWidgets[index] == nullptr) try {
+			const widgetComponent* component = static_cast<
+				const widgetComponent*>(modules.acquire(widgetIds[index]));
+			if(component == nullptr || component->create == nullptr)
+				throw moduleError("The module provides no widget " +
+					widgetName(index));
+			moduleWidgets[index].reset(component->create(context));
+		} catch(const moduleError& e) {
+			message = e.what();
+		}
+		return moduleWidgets[index].get();
+	}
+
+	/// Retrieve the widget shown in place of the object pane.
+	widget& lowerPane() {
+		if(shownPane == 0) return objectView;
+		return *moduleWidgets[shownPane - 1];
+	}
+
+	/// Show the next widget of the modules in place of the object pane,
+	/// or the object pane after the last one.
+	void switchPane() {
+		if(screen == nullptr) return;
+		message.clear();
+		size_t next = (shownPane + 1) % (widgetIds.size() + 1);
+		if(next != 0 && moduleWidget(next - 1) == nullptr) next = 0;
+		else if(next != 0) message = widgetName(next - 1);
+		detach(*screen);
+		shownPane = next;
+		layout(*screen);
+		updateStatus();
+	}
+
+	/// Append the event statistics to the file named by the variable.
+	void dumpStatistics() {
+		const char* target = std::getenv(eventStatisticsVariable);
+		eventStatistics* stats = bus.statistics();
+		if(stats == nullptr || target == nullptr || *target == 0)
+			message = std::string("set ") + eventStatisticsVariable +
+				" to record event statistics";
+		else try {
+			stats->dump(target);
+			message = std::string("statistics appended to ") + target;
+		} catch(const std::exception& e) {
+			message = e.what();
+		}
+		updateStatus();
+	}
+
+	/// Start searching the loaded footprints with the query typed.
+	void startSearch() {
+		message.clear();
+		searchGeneration = 0;
+		searching = false;
+		search.cancel();
+		if(!query.empty()) try {
+			searchGeneration = search.start(parseQuery(query), loaded, lazy);
+			searchJumped = false;
+			searching = true;
+		} catch(const std::invalid_argument& e) {
+			message = e.what();
+		} catch(const std::regex_error& e) {
+			message = std::string("invalid expression: ") + e.what();
+		}
+		updateStatus();
+	}
+
+	/// Handle the key typed into the query.
+	void type(int key) {
+		if(key == '\n' || key == KEY_ENTER) {
+			prompting = false;
+			startSearch();
+			return;
+		}
+		if(key == 27) prompting = false;
+		else if(key == KEY_BACKSPACE || key == 127 || key == '\b') {
+			if(!query.empty()) query.pop_back();
+		} else if(key >= 0x20 && key < 0x7f) query.push_back((char)key);
+		updateStatus();
+	}
+
+	virtual void handle(const logOpenedEvent& event) override {
+		total = event.footprints;
+		lazy = event.lazy;
+		objects.setLazy(lazy);
+		updateStatus();
+	}
+
+	virtual void handle(const footprintsLoadedEvent& event) override {
+		loaded = std::max<size_t>(loaded, event.end);
+		if(current == absent) select(0);
+		else updateStatus();
+	}
+
+	virtual void handle(const searchHitsEvent& event) override {
+		if(event.generation != searchGeneration) return;
+		if(event.finished) searching = false;
+		if(!searchJumped && event.end > event.begin) {
+			// Jump to the first hit from the current footprint, or the
+			// first hit if none is after it once finished.
+			uint32_t hit = search.nextHit(current == absent? 0 : current);
+			if(hit == absent && event.finished) hit = search.nextHit(0);
+			if(hit != absent) {
+				searchJumped = true;
+				select(hit);
+			}
+		}
+		updateStatus();
+	}
+
+	virtual void handle(const logLoadedEvent& event) override {
+		finished = true;
+		if(event.error != nullptr) try {
+			std::rethrow_exception(event.error);
+		} catch(const std::exception& e) {
+			message = e.what();
+		}
+		updateStatus();
+	}
+public:
+	/// Construct the viewer of the log being loaded.
+	viewer(priorityEventBus& bus, const snailLog& log, const std::string& path,
+		moduleRegistry& modules):
+		eventHandler<logOpenedEvent>(bus),
+		eventHandler<footprintsLoadedEvent>(bus),
+		eventHandler<logLoadedEvent>(bus), eventHandler<searchHitsEvent>(bus),
+		bus(bus), log(log), path(path), sources(log), objects(log),
+		sourceView(sources), objectView(log, objects), modules(modules),
+		context(moduleContext { &bus }),
+		widgetIds(modules.list(uidType::widget)),
+		moduleWidgets(widgetIds.size()), shownPane(0), screen(nullptr),
+		loaded(0), total(0), lazy(false), finished(false), current(absent),
+		search(log, bus), searchGeneration(0), searchJumped(false),
+		searching(false), prompting(false) {
+		updateStatus();
+	}
+
+	/// Show the message in the status bar.
+	void notify(const std::string& text) {
+		message = text;
+		updateStatus();
+	}
+
+	/// Whether the loading and the search have reported their last
+	/// events, and no event is left in the bus for the next flush, so
+	/// that there are no more events to wait for.
+	bool idle() const {
+		return finished && !searching && bus.backlog() == 0;
+	}
+
+	/// Place the widgets on the display and add them.
+	void layout(display& target) {
+		screen = &target;
+		int rows = std::max(target.rows(), 3), columns = target.columns();
+		int sourceRows = (rows - 1) / 2;
+		sourceView.place(rect { 0, 0, sourceRows, columns });
+		lowerPane().place(rect { sourceRows, 0, rows - 1 - sourceRows, columns });
+		status.place(rect { rows - 1, 0, 1, columns });
+		target.add(sourceView);
+		target.add(lowerPane());
+		target.add(status);
+	}
+
+	/// Remove the widgets from the display.
+	void detach(display& target) {
+		target.remove(sourceView);
+		target.remove(lowerPane());
+		target.remove(status);
+	}
+
+	/// Handle the key, returning whether the viewer should go on.
+	bool press(int key) {
+		if(prompting) {
+			type(key);
+			return true;
+		}
+		switch(key) {
+		case 'q': return false;
+		case 'n': case KEY_RIGHT:
+			if(current != absent) select(current + 1);
+			break;
+		case 'p': case KEY_LEFT:
+			if(current != absent && current > 0) select(current - 1);
+			break;
+		case 'g': select(0); break;
+		case 'G':
+			if(loaded > 0) select((uint32_t)(loaded - 1));
+			break;
+		case 'u':
+			if(current != absent) select(log.footprints.parent[current]);
+			break;
+		case 'j': case KEY_DOWN: objectView.move(1); break;
+		case 'k': case KEY_UP: objectView.move(-1); break;
+		case ' ': case '\n': case KEY_ENTER: objectView.toggle(); break;
+		case KEY_NPAGE: sourceView.scroll(sourceView.height() / 2); break;
+		case KEY_PPAGE: sourceView.scroll(-sourceView.height() / 2); break;
+		case '/':
+			prompting = true;
+			query.clear();
+			updateStatus();
+			break;
+		case ']':
+			if(searchGeneration != 0 && current != absent)
+				select(search.nextHit(current + 1));
+			break;
+		case '[':
+			if(searchGeneration != 0 && current != absent && current > 0)
+				select(search.previousHit(current - 1));
+			break;
+		case 'w': switchPane(); break;
+		case KEY_F(12): dumpStatistics(); break;
+		default: break;
+		}
+		return true;
+	}
+};
+
+} // Anonymous namespace.
 
 // Implementation of the viewer entry point.
-int main(int argc, char* argv[], char* envp[]) {
-	// The function is currently a stub.
-	return 0;
+int main(int argc, char* argv[]) {
+	loadOptions options;
+	options.lazyObjects = true;
+	int argi = 1;
+	for(; argi < argc && argv[argi][0] == '-'; ++ argi) {
+		if(std::strcmp(argv[argi], "-j") == 0 && argi + 1 < argc) {
+			char* end;
+			long value = std::strtol(argv[++ argi], &end, 10);
+			if(*end != '\0' || value <= 0) {
+				usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			options.threads = (size_t)value;
+		} else {
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+	if(argc - argi != 1) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+	std::string path(argv[argi]);
+
+	try {
+		// The modules are initialized by the bus on the first dispatch
+		// of their events, and finalized after the viewer is destroyed
+		// but before the bus is.
+		priorityEventBus bus;
+		moduleRegistry modules(moduleContext { &bus });
+		bus.activateBy(&modules);
+		std::vector<std::string> failures;
+		const char* directory = std::getenv(moduleDirectoryVariable);
+		if(directory != nullptr && *directory != 0) try {
+			modules.loadDirectory(directory, &failures);
+		} catch(const std::system_error& e) {
+			failures.push_back(e.what());
+		}
+
+		// The events of the loader wait in the bus until flushed, so the
+		// viewer subscribes after the loading starts and unsubscribes
+		// before the loading is cancelled.
+		display screen;
+		backgroundLoader loader(bus, path, options);
+		viewer view(bus, loader.target(), path, modules);
+		view.layout(screen);
+		if(!failures.empty()) view.notify(failures.back());
+		while(true) {
+			bus.flush();
+			failures = modules.takeFailures();
+			if(!failures.empty()) view.notify(failures.back());
+			screen.render();
+			int key = screen.readKey(view.idle()? -1 : loadingTimeout);
+			if(key == KEY_RESIZE) {
+				view.detach(screen);
+				view.layout(screen);
+				screen.repaint();
+			} else if(key >= 0 && !view.press(key)) break;
+		}
+		view.detach(screen);
+	} catch(const std::exception& e) {
+		std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
 }
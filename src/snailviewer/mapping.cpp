@@ -0,0 +1,99 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/mapping.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the memory mapped files with POSIX mmap.
+ */
+#include "snailviewer/mapping.hpp"
+#include <cerrno>
+#include <new>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace snailviewer {
+
+// The content pointed by empty mappings.
+static const char emptyRegion[1] = { 0 };
+
+mappedFile::mappedFile() noexcept: region(emptyRegion), length(0) {}
+
+mappedFile::mappedFile(const std::string& path):
+	region(emptyRegion), length(0) {
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if(fd < 0) throw std::system_error(errno,
+		std::system_category(), "Cannot open " + path);
+
+	struct stat st;
+	if(::fstat(fd, &st) < 0) {
+		int error = errno; ::close(fd);
+		throw std::system_error(error,
+			std::system_category(), "Cannot stat " + path);
+	}
+
+	if(st.st_size > 0) {
+		void* mapped = ::mmap(nullptr, (size_t)st.st_size,
+			PROT_READ, MAP_PRIVATE, fd, 0);
+		if(mapped == MAP_FAILED) {
+			int error = errno; ::close(fd);
+			throw std::system_error(error,
+				std::system_category(), "Cannot map " + path);
+		}
+		region = (const char*)mapped;
+		length = (size_t)st.st_size;
+	}
+	::close(fd);
+}
+
+mappedFile::mappedFile(mappedFile&& other) noexcept:
+	region(other.region), length(other.length) {
+	other.region = emptyRegion;
+	other.length = 0;
+}
+
+mappedFile& mappedFile::operator=(mappedFile&& other) noexcept {
+	if(this != &other) {
+		if(length > 0) ::munmap((void*)region, length);
+		region = other.region; length = other.length;
+		other.region = emptyRegion; other.length = 0;
+	}
+	return *this;
+}
+
+mappedFile::~mappedFile() {
+	if(length > 0) ::munmap((void*)region, length);
+}
+
+void* mapPages(size_t size) {
+	void* pages = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if(pages == MAP_FAILED) throw std::bad_alloc();
+	return pages;
+}
+
+void unmapPages(void* pages, size_t size) noexcept {
+	::munmap(pages, size);
+}
+
+} // namespace snailviewer.
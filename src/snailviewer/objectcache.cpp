@@ -0,0 +1,110 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/objectcache.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the cache of decoded objects.
+ */
+#include "snailviewer/objectcache.hpp"
+#include "snailviewer/loader.hpp"
+
+namespace snailviewer {
+
+constexpr size_t objectCache::defaultBudget;
+
+objectCache::objectCache(const snailLog& log, size_t budget):
+	log(log), budget(budget), usage(0), lazy(false) {}
+
+void objectCache::evict() {
+	while(usage > budget && recent.size() > 1) {
+		const entry& victim = recent.back();
+		usage -= victim.second->memoryUsage();
+		entries.erase(victim.first);
+		recent.pop_back();
+	}
+}
+
+std::shared_ptr<const decodedObjects> objectCache::get(uint32_t footprint) {
+	// There's nothing to decode for the logs loaded eagerly, so they
+	// share the same empty objects which are never cached.
+	static const std::shared_ptr<const decodedObjects> nothing(
+		new decodedObjects);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if(!lazy) return nothing;
+		auto it = entries.find(footprint);
+		if(it != entries.end()) {
+			recent.splice(recent.begin(), recent, it->second);
+			return it->second->second;
+		}
+	}
+
+	// Decode outside the lock so that other footprints could be looked
+	// up meanwhile, the first one decoded is kept if both decode it.
+	std::shared_ptr<decodedObjects> decoded(new decodedObjects);
+	decodeObjects(log, footprint, *decoded);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = entries.find(footprint);
+	if(it != entries.end()) {
+		recent.splice(recent.begin(), recent, it->second);
+		return it->second->second;
+	}
+	recent.push_front(entry(footprint, decoded));
+	entries.emplace(footprint, recent.begin());
+	usage += decoded->memoryUsage();
+	evict();
+	return decoded;
+}
+
+void objectCache::setLazy(bool lazyObjects) {
+	std::lock_guard<std::mutex> lock(mutex);
+	lazy = lazyObjects;
+}
+
+bool objectCache::isLazy() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return lazy;
+}
+
+void objectCache::setBudget(size_t bytes) {
+	std::lock_guard<std::mutex> lock(mutex);
+	budget = bytes;
+	evict();
+}
+
+size_t objectCache::memoryBudget() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return budget;
+}
+
+size_t objectCache::memoryUsage() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return usage;
+}
+
+void objectCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	recent.clear();
+	usage = 0;
+}
+
+} // namespace snailviewer.
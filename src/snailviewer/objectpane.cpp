@@ -0,0 +1,123 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/objectpane.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the object pane.
+ */
+#define NCURSES_NOMACROS
+#include "snailviewer/objectpane.hpp"
+#include "snailviewer/jsonsax.hpp"
+#include <algorithm>
+#include <curses.h>
+
+namespace snailviewer {
+
+objectPane::objectPane(const snailLog& log, objectCache& cache):
+	widget(paneId()), log(log), cache(cache),
+	footprint(absent), cursor(0), top(0) {}
+
+int objectPane::rowOf(size_t treeRow) const {
+	if(treeRow < top || treeRow - top + 1 >= (size_t)height()) return -1;
+	return (int)(treeRow - top + 1);
+}
+
+std::string objectPane::rowText(int row) const {
+	std::string text;
+	if(row == 0) {
+		if(footprint != absent) {
+			text = "#" + std::to_string(footprint) + ": " +
+				std::to_string(model.rows()) + " rows";
+			if(!message.empty()) text += " (" + message + ")";
+		}
+	} else {
+		size_t treeRow = top + (size_t)row - 1;
+		if(treeRow < model.rows()) {
+			objectRow info = model.at(treeRow);
+			text.append(2 * (size_t)info.depth, ' ');
+			text += info.expandable? (info.expanded? "- " : "+ ") : "  ";
+			size_t used = text.size();
+			if(used < (size_t)width())
+				text += model.text(info, (size_t)width() - used);
+		}
+	}
+	text.resize((size_t)width(), ' ');
+	return text;
+}
+
+void objectPane::paint(cursesWindow* window, const rect& area) {
+	for(int row = area.top; row < area.bottom(); ++ row) {
+		std::string text = rowText(row);
+		bool highlight = row == 0 || (row == rowOf(cursor) && model.rows() > 0);
+		if(highlight) wattron(window, A_REVERSE);
+		mvwaddnstr(window, row, area.left, text.c_str() + area.left, area.width);
+		if(highlight) wattroff(window, A_REVERSE);
+	}
+}
+
+bool objectPane::follow() {
+	size_t rows = height() > 1? (size_t)height() - 1 : 1;
+	size_t previous = top;
+	if(cursor < top) top = cursor;
+	else if(cursor >= top + rows) top = cursor - rows + 1;
+	if(top == previous) return false;
+	invalidate(rect { 1, 0, height() - 1, width() });
+	return true;
+}
+
+void objectPane::show(uint32_t index) {
+	footprint = index;
+	message.clear();
+	cursor = top = 0;
+	model.clear();
+	if(index != absent) try {
+		model.reset(log, index, cache);
+	} catch(const jsonError& e) {
+		message = e.what();
+	}
+	invalidate();
+}
+
+void objectPane::move(long rows) {
+	if(model.rows() == 0) return;
+	long target = (long)cursor + rows;
+	target = std::max<long>(0, std::min<long>(target, (long)model.rows() - 1));
+	if((size_t)target == cursor) return;
+
+	// Only the rows the cursor leaves and enters change unless scrolled.
+	int previous = rowOf(cursor);
+	cursor = (size_t)target;
+	if(follow()) return;
+	if(previous >= 0) invalidateRow(previous);
+	invalidateRow(rowOf(cursor));
+}
+
+void objectPane::toggle() {
+	if(model.rows() == 0) return;
+	if(model.collapse(cursor) == 0 && model.expand(cursor) == 0) return;
+
+	// The rows from the cursor downwards are shifted, while the ones
+	// above are untouched.
+	invalidateRow(0);
+	int row = rowOf(cursor);
+	if(row >= 0) invalidate(rect { row, 0, height() - row, width() });
+}
+
+} // namespace snailviewer.
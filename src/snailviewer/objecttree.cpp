@@ -0,0 +1,291 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/objecttree.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the model of the object tree.
+ */
+#include "snailviewer/objecttree.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace snailviewer {
+
+objectTreeModel::objectTreeModel(): log(nullptr) {
+	clear();
+}
+
+void objectTreeModel::clear() {
+	log = nullptr;
+	decoded.reset();
+	scopes.clear();
+	scopeBindings.clear();
+	root.object = absent;
+	root.index = 0;
+	root.children = 0;
+	root.extra = 0;
+	root.parent = nullptr;
+	root.expanded.reset();
+}
+
+void objectTreeModel::split(std::unique_ptr<node> treap, uint32_t index,
+		std::unique_ptr<node>& lower, std::unique_ptr<node>& higher) {
+	if(treap == nullptr) {
+		lower.reset();
+		higher.reset();
+	} else if(treap->index < index) {
+		split(std::move(treap->right), index, treap->right, higher);
+		update(*treap);
+		lower = std::move(treap);
+	} else {
+		split(std::move(treap->left), index, lower, treap->left);
+		update(*treap);
+		higher = std::move(treap);
+	}
+}
+
+std::unique_ptr<objectTreeModel::node> objectTreeModel::merge(
+		std::unique_ptr<node> lower, std::unique_ptr<node> higher) {
+	if(lower == nullptr) return higher;
+	if(higher == nullptr) return lower;
+	if(lower->priority > higher->priority) {
+		lower->right = merge(std::move(lower->right), std::move(higher));
+		update(*lower);
+		return lower;
+	}
+	higher->left = merge(std::move(lower), std::move(higher->left));
+	update(*higher);
+	return higher;
+}
+
+objectTreeModel::node* objectTreeModel::find(
+		const node& parent, uint32_t index) noexcept {
+	node* treap = parent.expanded.get();
+	while(treap != nullptr && treap->index != index)
+		treap = (index < treap->index? treap->left : treap->right).get();
+	return treap;
+}
+
+void objectTreeModel::insert(node& parent, std::unique_ptr<node> child) {
+	// The priorities are scrambled indices, so that the treap stays
+	// balanced when the children are expanded in order.
+	uint32_t index = child->index;
+	child->priority = (index ^ (index >> 16)) * 0x45d9f3bu;
+	child->priority ^= child->priority >> 16;
+	child->parent = &parent;
+	update(*child);
+	std::unique_ptr<node> lower, higher;
+	split(std::move(parent.expanded), index, lower, higher);
+	parent.expanded = merge(merge(std::move(lower), std::move(child)),
+		std::move(higher));
+}
+
+void objectTreeModel::propagate(node& parent,
+		size_t rows, bool removed) noexcept {
+	for(node* ancestor = &parent; ancestor != nullptr;
+			ancestor = ancestor->parent) {
+		if(removed) ancestor->extra -= rows;
+		else ancestor->extra += rows;
+		if(ancestor->parent == nullptr) break;
+
+		// The nodes of the treap above the ancestor are those along
+		// the path searching for it.
+		node* treap = ancestor->parent->expanded.get();
+		while(treap != nullptr) {
+			if(removed) treap->subtreeRows -= rows;
+			else treap->subtreeRows += rows;
+			if(treap == ancestor) break;
+			treap = (ancestor->index < treap->index?
+				treap->left : treap->right).get();
+		}
+	}
+}
+
+const symbolTable& objectTreeModel::names() const {
+	return decoded != nullptr? decoded->names : log->names;
+}
+
+const objectStore& objectTreeModel::objects() const {
+	return decoded != nullptr? decoded->objects : log->objects;
+}
+
+const objectBinding& objectTreeModel::binding(uint32_t index) const {
+	return decoded != nullptr? decoded->bindings[index] : log->bindings[index];
+}
+
+size_t objectTreeModel::childCount(uint32_t object) const {
+	const objectNode& data = objects()[object];
+	return data.trait == objectTrait::structure? data.count : 0;
+}
+
+void objectTreeModel::reset(const snailLog& shown,
+		uint32_t footprint, objectCache& cache) {
+	clear();
+	log = &shown;
+	uint32_t begin, end;
+	if(cache.isLazy()) {
+		decoded = cache.get(footprint);
+		begin = 0;
+		end = (uint32_t)decoded->bindings.size();
+	} else {
+		begin = shown.footprints.bindingBegin(footprint);
+		end = shown.footprints.bindingEnd(footprint);
+	}
+
+	// The bindings are grouped by their scopes, in the order that the
+	// scopes first appear, like the JSON writer does.
+	for(uint32_t b = begin; b < end; ++ b) {
+		uint32_t scope = binding(b).scope;
+		auto it = std::find(scopes.begin(), scopes.end(), scope);
+		size_t group = (size_t)(it - scopes.begin());
+		if(it == scopes.end()) {
+			scopes.push_back(scope);
+			scopeBindings.emplace_back();
+		}
+		scopeBindings[group].push_back(b);
+	}
+
+	// The scopes are expanded initially.
+	root.children = scopes.size();
+	for(size_t i = 0; i < scopes.size(); ++ i) {
+		std::unique_ptr<node> scope(new node);
+		scope->object = absent;
+		scope->index = (uint32_t)i;
+		scope->children = scopeBindings[i].size();
+		scope->extra = 0;
+		root.extra += scope->children;
+		insert(root, std::move(scope));
+	}
+}
+
+objectTreeModel::position objectTreeModel::locate(size_t row) const {
+	if(row >= rows()) throw std::out_of_range("Row out of range");
+	const node* parent = &root;
+	uint32_t depth = 0;
+	while(true) {
+		// The rows before the i-th child are i plus the rows of the
+		// expanded children before it, which are summed up by the
+		// subtrees of the treap passed by while searching.
+		size_t skipped = 0;
+		const node* treap = parent->expanded.get();
+		const node* descended = nullptr;
+		while(treap != nullptr) {
+			size_t self = treap->index + skipped + treapRows(treap->left);
+			if(row < self) treap = treap->left.get();
+			else if(row == self)
+				return position { parent, treap->index, depth };
+			else if(row <= self + treap->rows()) {
+				row -= self + 1;
+				descended = treap;
+				break;
+			} else {
+				skipped += treapRows(treap->left) + treap->rows();
+				treap = treap->right.get();
+			}
+		}
+		if(descended == nullptr)
+			return position { parent, (uint32_t)(row - skipped), depth };
+		parent = descended;
+		++ depth;
+	}
+}
+
+void objectTreeModel::child(const node& parent, uint32_t index,
+		uint32_t depth, uint32_t& object, uint32_t& name) const {
+	if(depth == 0) {
+		object = absent;
+		name = scopes[index];
+	} else if(depth == 1) {
+		// The scopes are the only nodes of depth 0, so the parent is the
+		// node of the scope.
+		const objectBinding& bound =
+			binding(scopeBindings[parent.index][index]);
+		object = bound.object;
+		name = bound.name;
+	} else {
+		const objectStore& store = objects();
+		const objectField& field = store.fields(store[parent.object])[index];
+		object = field.object;
+		name = field.name;
+	}
+}
+
+objectRow objectTreeModel::at(size_t row) const {
+	position pos = locate(row);
+	objectRow result;
+	result.depth = pos.depth;
+	child(*pos.parent, pos.index, pos.depth, result.object, result.name);
+	result.expanded = find(*pos.parent, pos.index) != nullptr;
+	result.expandable = result.object == absent || childCount(result.object) > 0;
+	return result;
+}
+
+std::string objectTreeModel::text(const objectRow& row, size_t limit) const {
+	const symbolTable& symbols = names();
+	std::string out(symbols.data(row.name), symbols.length(row.name));
+	if(row.object == absent) return out;
+	const objectStore& store = objects();
+	const objectNode& data = store[row.object];
+	out += " = ";
+	if(data.type != absent) {
+		out.append(symbols.data(data.type), symbols.length(data.type));
+		out.push_back(' ');
+	}
+	if(data.trait == objectTrait::structure)
+		out += "{" + std::to_string(data.count) + " fields}";
+	else out.append(store.literalData(data),
+		std::min((size_t)data.count, limit > out.size()? limit - out.size() : 0));
+	if(out.size() > limit) out.resize(limit);
+	return out;
+}
+
+size_t objectTreeModel::expand(size_t row) {
+	position pos = locate(row);
+	node& parent = const_cast<node&>(*pos.parent);
+	if(find(parent, pos.index) != nullptr) return 0;
+	uint32_t object, name;
+	child(parent, pos.index, pos.depth, object, name);
+	size_t count = pos.depth == 0? scopeBindings[pos.index].size() : childCount(object);
+	if(count == 0) return 0;
+
+	std::unique_ptr<node> expanded(new node);
+	expanded->object = object;
+	expanded->index = pos.index;
+	expanded->children = count;
+	expanded->extra = 0;
+	insert(parent, std::move(expanded));
+	propagate(parent, count, false);
+	return count;
+}
+
+size_t objectTreeModel::collapse(size_t row) {
+	position pos = locate(row);
+	node& parent = const_cast<node&>(*pos.parent);
+	std::unique_ptr<node> lower, collapsed, higher;
+	split(std::move(parent.expanded), pos.index, lower, higher);
+	split(std::move(higher), pos.index + 1, collapsed, higher);
+	parent.expanded = merge(std::move(lower), std::move(higher));
+	if(collapsed == nullptr) return 0;
+	size_t count = collapsed->rows();
+	propagate(parent, count, true);
+	return count;
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,113 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/prioritybus.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the priority event bus.
+ */
+#include "snailviewer/prioritybus.hpp"
+#include <algorithm>
+
+namespace snailviewer {
+
+constexpr size_t priorityEventBus::defaultBatchLimit;
+
+void priorityEventBus::subscribe(uid id, eventHandler<void*>& h) {
+	handlers.subscribe(id, h);
+}
+
+void priorityEventBus::unsubscribe(uid id, eventHandler<void*>& h) {
+	handlers.unsubscribe(id, h);
+}
+
+void priorityEventBus::broadcast(uid id, std::unique_ptr<eventHolder> evh) {
+	eventPriority priority = evh->priority();
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	pendingEvent event { id, std::move(evh) };
+	switch(priority) {
+	case eventPriority::urgent: urgent.push_back(std::move(event)); break;
+	case eventPriority::background: background.push_back(std::move(event)); break;
+	default: normal.push_back(std::move(event)); break;
+	}
+	handlers.sampleDepth(urgent.size() + normal.size() + background.size());
+}
+
+size_t priorityEventBus::deliver() {
+	size_t count = flushing.size();
+	for(pendingEvent& event : flushing) {
+		handlers.dispatch(event.id, event.holder->get());
+		event.holder.reset();
+	}
+	flushing.clear();
+	return count;
+}
+
+size_t priorityEventBus::deliverUrgent() {
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		if(urgent.empty()) return 0;
+		flushing.swap(urgent);
+	}
+	return deliver();
+}
+
+size_t priorityEventBus::flush(size_t batchLimit) {
+	// The events left by a throwing handler are discarded.
+	flushing.clear();
+	size_t count = deliverUrgent();
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		flushing.swap(normal);
+	}
+	count += deliver();
+
+	// Take the background events to broadcast, and group them by uids,
+	// preserving the order inside each group.
+	batching.clear();
+	{
+		std::lock_guard<std::mutex> lock(pendingMutex);
+		while(batching.size() < batchLimit && !background.empty()) {
+			batching.push_back(std::move(background.front()));
+			background.pop_front();
+		}
+	}
+	auto begin = batching.begin();
+	while(begin != batching.end()) {
+		uid id = begin->id;
+		auto end = std::stable_partition(begin, batching.end(),
+			[id](const pendingEvent& event) { return event.id == id; });
+		count += deliverUrgent();
+		batch.clear();
+		for(auto it = begin; it != end; ++ it)
+			batch.push_back(it->holder->get());
+		handlers.dispatchBatch(id, batch.data(), batch.size());
+		count += batch.size();
+		begin = end;
+	}
+	batching.clear();
+	return count;
+}
+
+size_t priorityEventBus::backlog() {
+	std::lock_guard<std::mutex> lock(pendingMutex);
+	return urgent.size() + normal.size() + background.size();
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,262 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/registry.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the module registry with POSIX dlopen.
+ */
+#include "snailviewer/registry.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <system_error>
+#include <dirent.h>
+#include <dlfcn.h>
+
+namespace snailviewer {
+
+// Helpers for the module registry.
+namespace {
+
+/// Render the uid for the error messages.
+std::string uidText(const uid& id) {
+	std::string text;
+	auto append = [&](const char* data, size_t length) {
+		for(size_t i = 0; i < length && data[i] != 0; ++ i)
+			text.push_back(data[i] >= 0x20 && data[i] < 0x7f? data[i] : '?');
+	};
+	append(id.module, sizeof(id.module));
+	text.push_back('.');
+	append(id.author, sizeof(id.author));
+	text.push_back('.');
+	append(id.name, sizeof(id.name));
+	return text;
+}
+
+/// Whether the name of the uid is nil.
+bool nilName(const uid& id) {
+	return std::all_of(id.name, id.name + sizeof(id.name),
+		[](char c) { return c == 0; });
+}
+
+/// Whether the file name ends with ".so".
+bool sharedObject(const std::string& name) {
+	return name.size() > 3 && name.compare(name.size() - 3, 3, ".so") == 0;
+}
+
+} // Anonymous namespace.
+
+moduleRegistry::moduleRegistry(const moduleContext& context): context(context) {}
+
+moduleRegistry::~moduleRegistry() {
+	for(size_t i = initializeOrder.size(); i > 0; -- i) {
+		const loadedModule& module = *modules[initializeOrder[i - 1]];
+		if(module.descriptor->finalize != nullptr)
+			module.descriptor->finalize();
+	}
+	for(size_t i = modules.size(); i > 0; -- i)
+		if(modules[i - 1]->handle != nullptr) ::dlclose(modules[i - 1]->handle);
+}
+
+const moduleRegistry::componentEntry* moduleRegistry::lookup(uid id) const {
+	auto it = std::lower_bound(components.begin(), components.end(), id,
+		[](const componentEntry& entry, const uid& id) { return entry.id < id; });
+	return it != components.end() && it->id == id? &*it : nullptr;
+}
+
+void moduleRegistry::add(std::unique_ptr<loadedModule> module) {
+	const moduleDescriptor& descriptor = *module->descriptor;
+	std::string source = module->path.empty()?
+		uidText(descriptor.id) : module->path;
+	if(descriptor.abiVersion != moduleAbiVersion)
+		throw moduleError(source + ": built for module interface version " +
+			std::to_string(descriptor.abiVersion) + " instead of " +
+			std::to_string(moduleAbiVersion));
+	if(!descriptor.id.hasType(uidType::module) || !nilName(descriptor.id))
+		throw moduleError(source + ": invalid module uid " + uidText(descriptor.id));
+	if(descriptor.componentCount > 0 && (descriptor.components == nullptr ||
+			descriptor.resolve == nullptr))
+		throw moduleError(source + ": components declared without resolver");
+
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	for(const std::unique_ptr<loadedModule>& loaded : modules)
+		if(loaded->descriptor->id == descriptor.id)
+			throw moduleError(source + ": module " +
+				uidText(descriptor.id) + " is already loaded");
+
+	// Validate the components before indexing any of them.
+	uint32_t index = (uint32_t)modules.size();
+	std::vector<componentEntry> added;
+	for(size_t i = 0; i < descriptor.componentCount; ++ i) {
+		const uid& id = descriptor.components[i].id;
+		if(id.hasType(uidType::module))
+			throw moduleError(source + ": component " + uidText(id) +
+				" must not be a module");
+		if(lookup(id) != nullptr) throw moduleError(source +
+			": component " + uidText(id) + " is already registered");
+		added.push_back(componentEntry { id, index, (uint32_t)i });
+	}
+	std::sort(added.begin(), added.end(), [](const componentEntry& a,
+		const componentEntry& b) { return a.id < b.id; });
+	auto duplicate = std::adjacent_find(added.begin(), added.end(),
+		[](const componentEntry& a, const componentEntry& b) { return a.id == b.id; });
+	if(duplicate != added.end()) throw moduleError(source +
+		": component " + uidText(duplicate->id) + " is declared twice");
+
+	modules.push_back(std::move(module));
+	size_t middle = components.size();
+	components.insert(components.end(), added.begin(), added.end());
+	std::inplace_merge(components.begin(), components.begin() + middle,
+		components.end(), [](const componentEntry& a, const componentEntry& b) {
+			return a.id < b.id; });
+}
+
+void moduleRegistry::add(const moduleDescriptor& descriptor) {
+	std::unique_ptr<loadedModule> module(new loadedModule);
+	module->handle = nullptr;
+	module->descriptor = &descriptor;
+	module->initialized = false;
+	add(std::move(module));
+}
+
+void moduleRegistry::load(const std::string& path) {
+	// The symbols are resolved lazily and kept local, so that loading
+	// is cheap and the modules never see each other's symbols.
+	void* handle = ::dlopen(path.c_str(), RTLD_LAZY | RTLD_LOCAL);
+	if(handle == nullptr) {
+		const char* message = ::dlerror();
+		throw moduleError(message != nullptr? message : "Cannot load " + path);
+	}
+	struct handleGuard {
+		void* handle;
+		~handleGuard() { if(handle != nullptr) ::dlclose(handle); }
+	} guard { handle };
+
+	void* symbol = ::dlsym(handle, moduleEntrySymbol);
+	if(symbol == nullptr) throw moduleError(path + ": no " +
+		moduleEntrySymbol + " exported");
+	moduleEntry entry;
+	*reinterpret_cast<void**>(&entry) = symbol;
+	const moduleDescriptor* descriptor = entry();
+	if(descriptor == nullptr) throw moduleError(path + ": no descriptor");
+
+	std::unique_ptr<loadedModule> module(new loadedModule);
+	module->path = path;
+	module->handle = handle;
+	module->descriptor = descriptor;
+	module->initialized = false;
+	add(std::move(module));
+	guard.handle = nullptr;
+}
+
+size_t moduleRegistry::loadDirectory(const std::string& directory,
+		std::vector<std::string>* errors) {
+	DIR* dir = ::opendir(directory.c_str());
+	if(dir == nullptr) throw std::system_error(errno,
+		std::system_category(), "Cannot open " + directory);
+	std::vector<std::string> names;
+	while(struct dirent* item = ::readdir(dir))
+		if(sharedObject(item->d_name)) names.push_back(item->d_name);
+	::closedir(dir);
+	std::sort(names.begin(), names.end());
+
+	size_t count = 0;
+	for(const std::string& name : names) {
+		try {
+			load(directory + "/" + name);
+			++ count;
+		} catch(const moduleError& e) {
+			if(errors != nullptr) errors->push_back(e.what());
+		}
+	}
+	return count;
+}
+
+const moduleComponent* moduleRegistry::find(uid id) const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	const componentEntry* entry = lookup(id);
+	if(entry == nullptr) return nullptr;
+	return &modules[entry->module]->descriptor->components[entry->component];
+}
+
+std::vector<uid> moduleRegistry::list(uidType type) const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	std::vector<uid> ids;
+	for(const componentEntry& entry : components)
+		if(entry.id.hasType(type)) ids.push_back(entry.id);
+	return ids;
+}
+
+const void* moduleRegistry::acquire(uid id) {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	const componentEntry* entry = lookup(id);
+	if(entry == nullptr) return nullptr;
+	uint32_t index = entry->module;
+	loadedModule& module = *modules[index];
+	if(!module.initialized) {
+		// Marked before initializing, so that the module acquiring its
+		// own components while initializing does not recurse.
+		module.initialized = true;
+		bool succeeded = false;
+		try {
+			succeeded = module.descriptor->initialize == nullptr ||
+				module.descriptor->initialize(context);
+		} catch(...) {
+			module.initialized = false;
+			throw;
+		}
+		if(!succeeded) {
+			module.initialized = false;
+			throw moduleError("Module " + uidText(module.descriptor->id) +
+				" fails to initialize");
+		}
+		initializeOrder.push_back(index);
+	}
+	return module.descriptor->resolve(id);
+}
+
+bool moduleRegistry::initialized(uid id) const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	const componentEntry* entry = lookup(id);
+	return entry != nullptr && modules[entry->module]->initialized;
+}
+
+void moduleRegistry::activate(uid id) {
+	if(!id.hasType(uidType::event)) return;
+	try {
+		acquire(id);
+	} catch(const moduleError& e) {
+		std::lock_guard<std::recursive_mutex> lock(mutex);
+		failures.push_back(e.what());
+	}
+}
+
+std::vector<std::string> moduleRegistry::takeFailures() {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	std::vector<std::string> taken;
+	taken.swap(failures);
+	return taken;
+}
+
+size_t moduleRegistry::moduleCount() const {
+	std::lock_guard<std::recursive_mutex> lock(mutex);
+	return modules.size();
+}
+
+} // namespace snailviewer.
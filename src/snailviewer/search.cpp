@@ -0,0 +1,399 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/search.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the search engine.
+ */
+#include "snailviewer/search.hpp"
+#include "snailviewer/jsonsax.hpp"
+#include "snailviewer/loader.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <future>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace snailviewer {
+
+// Helpers for parsing and matching the queries.
+namespace {
+
+/// The number of footprints in a block when only the columns are
+/// checked, and when the objects are checked as well.
+constexpr uint32_t columnBlock = 65536;
+constexpr uint32_t objectBlock = 256;
+
+/// The number of blocks in flight per worker.
+constexpr size_t blocksPerWorker = 4;
+
+/// Whether the term begins with the prefix, removing the prefix.
+bool consume(std::string& term, const char* prefix) {
+	size_t length = std::strlen(prefix);
+	if(term.compare(0, length, prefix) != 0) return false;
+	term.erase(0, length);
+	return true;
+}
+
+/// Whether the symbol is the string.
+bool symbolIs(const symbolTable& names, uint32_t symbol, const std::string& name) {
+	return symbol != absent && names.length(symbol) == name.size() &&
+		std::memcmp(names.data(symbol), name.data(), name.size()) == 0;
+}
+
+/// Match the strings of the table with the regular expression, where
+/// the empty expression matches all.
+std::vector<char> matchStrings(const stringTable& strings, const std::string& pattern) {
+	std::vector<char> matched(strings.size(), 1);
+	if(pattern.empty()) return matched;
+	std::regex expression(pattern);
+	for(uint32_t i = 0; i < strings.size(); ++ i)
+		matched[i] = std::regex_search(strings.data(i),
+			strings.data(i) + strings.length(i), expression);
+	return matched;
+}
+
+/// Whether the column value is one of the matched strings.
+inline bool matchColumn(const std::vector<char>& matched, bool any, uint32_t value) {
+	return any || (value < matched.size() && matched[value]);
+}
+
+} // Anonymous namespace.
+
+searchQuery parseQuery(const std::string& text) {
+	searchQuery query;
+	std::istringstream terms(text);
+	std::string term;
+	while(terms >> term) {
+		size_t equals = term.find("==");
+		if(consume(term, "function~")) query.function = term;
+		else if(consume(term, "file~")) query.file = term;
+		else if(consume(term, "line=")) {
+			char* end;
+			errno = 0;
+			unsigned long line = std::strtoul(term.c_str(), &end, 10);
+			if(term.empty() || *end != 0 || errno != 0 || line >= absent)
+				throw std::invalid_argument("Invalid line " + term);
+			query.line = (uint32_t)line;
+		} else if(equals != std::string::npos) {
+			bindingCondition condition;
+			condition.path = term.substr(0, equals);
+			condition.value = term.substr(equals + 2);
+			size_t colon = condition.path.find(':');
+			if(colon != std::string::npos) {
+				condition.scope = condition.path.substr(0, colon);
+				condition.path.erase(0, colon + 1);
+			}
+			query.bindings.push_back(condition);
+		} else {
+			if(!query.text.empty()) query.text.push_back(' ');
+			query.text += term;
+		}
+	}
+	return query;
+}
+
+/// The matcher of the footprints, shared by the blocks being scanned.
+class searchEngine::footprintMatcher {
+	/// The condition on the bound object with its path split.
+	struct condition {
+		std::string scope;
+		std::vector<std::string> path;
+		std::string value;
+	};
+
+	/// The log to search.
+	const snailLog& log;
+
+	/// Whether the objects of footprints are decoded lazily.
+	bool lazy;
+
+	/// Whether each function and file matches, and whether any does.
+	std::vector<char> functions, files;
+	bool anyFunction, anyFile;
+
+	/// The line of the footprint, or absent.
+	uint32_t line;
+
+	/// The conditions on the bound objects.
+	std::vector<condition> conditions;
+
+	/// The text that some literal contains, or empty.
+	std::string text;
+
+	/// The texts that must be inside the text of the objects of the
+	/// footprints loaded lazily, checked before decoding them.
+	std::vector<std::string> needles;
+
+	/// Whether some literal of the objects contains the text.
+	static bool anyContains(const objectStore& objects, const std::string& text) {
+		for(uint32_t i = 0; i < objects.size(); ++ i) {
+			const objectNode& node = objects[i];
+			if(node.trait == objectTrait::structure) continue;
+			const char* data = objects.literalData(node);
+			if(std::search(data, data + node.count, text.begin(), text.end())
+				!= data + node.count) return true;
+		}
+		return false;
+	}
+
+	/// Follow the fields of the path from the bound object.
+	uint32_t follow(const symbolTable& names, const objectStore& objects,
+			uint32_t object, const std::vector<std::string>& path) const {
+		for(size_t i = 1; i < path.size() && object != absent; ++ i) {
+			const objectNode& node = objects[object];
+			uint32_t next = absent;
+			if(node.trait == objectTrait::structure) {
+				const objectField* fields = objects.fields(node);
+				for(uint32_t j = 0; j < node.count && next == absent; ++ j)
+					if(symbolIs(names, fields[j].name, path[i]))
+						next = fields[j].object;
+			}
+			object = next;
+		}
+		return object;
+	}
+
+	/// Whether the bindings satisfy the condition.
+	bool satisfy(const symbolTable& names, const objectStore& objects,
+			const objectBinding* first, const objectBinding* last,
+			const condition& wanted) const {
+		for(const objectBinding* binding = first; binding != last; ++ binding) {
+			if(!wanted.scope.empty() && !symbolIs(names, binding->scope, wanted.scope))
+				continue;
+			if(!symbolIs(names, binding->name, wanted.path[0])) continue;
+			uint32_t object = follow(names, objects, binding->object, wanted.path);
+			if(object == absent) continue;
+			const objectNode& node = objects[object];
+			if(node.trait != objectTrait::structure && node.count == wanted.value.size() &&
+				std::memcmp(objects.literalData(node), wanted.value.data(), node.count) == 0)
+				return true;
+		}
+		return false;
+	}
+
+	/// Whether some literal reachable from the bindings contains the text.
+	/// The objects are shared and the root objects may refer to each
+	/// other in cycles, so each object is visited once.
+	bool contain(const objectStore& objects,
+			const objectBinding* first, const objectBinding* last) const {
+		std::vector<uint32_t> pending;
+		std::unordered_set<uint32_t> visited;
+		for(const objectBinding* binding = first; binding != last; ++ binding)
+			pending.push_back(binding->object);
+		while(!pending.empty()) {
+			uint32_t object = pending.back();
+			pending.pop_back();
+			if(!visited.insert(object).second) continue;
+			const objectNode& node = objects[object];
+			if(node.trait == objectTrait::structure) {
+				const objectField* fields = objects.fields(node);
+				for(uint32_t j = 0; j < node.count; ++ j)
+					pending.push_back(fields[j].object);
+			} else {
+				const char* data = objects.literalData(node);
+				if(std::search(data, data + node.count, text.begin(), text.end())
+					!= data + node.count) return true;
+			}
+		}
+		return false;
+	}
+
+	/// Whether the objects satisfy the conditions.
+	bool matchObjects(const symbolTable& names, const objectStore& objects,
+			const objectBinding* first, const objectBinding* last) const {
+		for(const condition& wanted : conditions)
+			if(!satisfy(names, objects, first, last, wanted)) return false;
+		return text.empty() || contain(objects, first, last);
+	}
+public:
+	/// Compile the query for the log.
+	footprintMatcher(const snailLog& log, const searchQuery& query,
+		bool lazy): log(log), lazy(lazy),
+		functions(matchStrings(log.functions, query.function)),
+		files(matchStrings(log.files, query.file)),
+		anyFunction(query.function.empty()), anyFile(query.file.empty()),
+		line(query.line), text(query.text) {
+		for(const bindingCondition& binding : query.bindings) {
+			condition compiled;
+			compiled.scope = binding.scope;
+			compiled.value = binding.value;
+			std::istringstream path(binding.path);
+			std::string segment;
+			while(std::getline(path, segment, '.')) compiled.path.push_back(segment);
+			if(compiled.path.empty()) compiled.path.emplace_back();
+			conditions.push_back(compiled);
+		}
+
+		// The literals of the footprints loaded lazily are the verbatim
+		// text of their objects, unless they are the root objects. So
+		// the text absent from the root objects must be inside the text
+		// of the footprint for it to match.
+		if(!lazy) return;
+		std::vector<std::string> wanted;
+		for(const condition& compiled : conditions) wanted.push_back(compiled.value);
+		wanted.push_back(text);
+		for(const std::string& needle : wanted)
+			if(!needle.empty() && !anyContains(log.objects, needle))
+				needles.push_back(needle);
+	}
+
+	/// Whether the objects are checked.
+	bool needsObjects() const noexcept { return !conditions.empty() || !text.empty(); }
+
+	/// Whether the footprint matches the query.
+	bool match(uint32_t footprint) const {
+		const footprintTable& fp = log.footprints;
+		if(line != absent && fp.line[footprint] != line) return false;
+		if(!matchColumn(functions, anyFunction, fp.function[footprint])) return false;
+		if(!matchColumn(files, anyFile, fp.file[footprint])) return false;
+		if(!needsObjects()) return true;
+
+		// The objects of lazily loaded logs are decoded here instead of
+		// through the cache, which would be flooded by the scanning.
+		if(!lazy) {
+			const objectBinding* bindings = log.bindings.data();
+			return matchObjects(log.names, log.objects,
+				bindings + fp.bindingBegin(footprint),
+				bindings + fp.bindingEnd(footprint));
+		}
+		const textRange& range = log.objectTexts[footprint];
+		for(const std::string& needle : needles)
+			if(range.begin == nullptr || std::search(range.begin, range.end,
+				needle.begin(), needle.end()) == range.end) return false;
+		decodedObjects decoded;
+		try {
+			decodeObjects(log, footprint, decoded);
+		} catch(const jsonError&) {
+			return false;
+		}
+		return matchObjects(decoded.names, decoded.objects,
+			decoded.bindings.begin(), decoded.bindings.end());
+	}
+};
+
+searchEngine::searchEngine(const snailLog& log, eventBus& bus, size_t threads):
+	log(log), bus(bus), generation(0), scannedCount(0),
+	done(true), pool(threads) {}
+
+searchEngine::~searchEngine() { cancel(); }
+
+void searchEngine::cancel() {
+	generation.fetch_add(1);
+	if(merger.joinable()) merger.join();
+	std::lock_guard<std::mutex> lock(hitMutex);
+	hitList.clear();
+	scannedCount = 0;
+	done = true;
+}
+
+uint64_t searchEngine::start(const searchQuery& query,
+		size_t count, bool lazy) {
+	std::shared_ptr<const footprintMatcher> matcher(
+		new footprintMatcher(log, query, lazy));
+	cancel();
+	uint64_t current = generation.load();
+	{
+		std::lock_guard<std::mutex> lock(hitMutex);
+		done = false;
+	}
+	merger = std::thread(&searchEngine::merge, this, matcher, current, (uint32_t)count);
+	return current;
+}
+
+void searchEngine::merge(std::shared_ptr<const footprintMatcher> matcher,
+		uint64_t current, uint32_t count) {
+	uint32_t block = matcher->needsObjects()? objectBlock : columnBlock;
+	std::atomic<uint64_t>& latest = generation;
+	std::deque<std::future<std::vector<uint32_t>>> inflight;
+	size_t window = pool.size() * blocksPerWorker;
+	uint32_t next = 0, merged = 0;
+	do {
+		// Keep the window of blocks filled.
+		while(next < count && inflight.size() < window) {
+			uint32_t begin = next, end = count - next > block? next + block : count;
+			inflight.push_back(pool.submit([matcher, begin, end, current, &latest]() {
+				std::vector<uint32_t> hits;
+				for(uint32_t i = begin; i < end; ++ i) {
+					if(latest.load(std::memory_order_relaxed) != current) break;
+					if(matcher->match(i)) hits.push_back(i);
+				}
+				return hits;
+			}));
+			next = end;
+		}
+
+		// Merge the earliest block, which are abandoned once cancelled.
+		std::vector<uint32_t> hits;
+		if(!inflight.empty()) {
+			hits = inflight.front().get();
+			inflight.pop_front();
+			merged = count - merged > block? merged + block : count;
+		}
+		if(generation.load() != current) return;
+		searchHitsEvent event;
+		{
+			std::lock_guard<std::mutex> lock(hitMutex);
+			event.begin = hitList.size();
+			hitList.insert(hitList.end(), hits.begin(), hits.end());
+			event.end = hitList.size();
+			scannedCount = merged;
+			done = merged == count;
+		}
+		event.generation = current;
+		event.scanned = merged;
+		event.finished = merged == count;
+		bus.broadcast(event);
+	} while(merged < count);
+}
+
+uint32_t searchEngine::nextHit(uint32_t footprint) const {
+	std::lock_guard<std::mutex> lock(hitMutex);
+	auto it = std::lower_bound(hitList.begin(), hitList.end(), footprint);
+	return it == hitList.end()? absent : *it;
+}
+
+uint32_t searchEngine::previousHit(uint32_t footprint) const {
+	std::lock_guard<std::mutex> lock(hitMutex);
+	auto it = std::upper_bound(hitList.begin(), hitList.end(), footprint);
+	return it == hitList.begin()? absent : *(it - 1);
+}
+
+size_t searchEngine::hits() const {
+	std::lock_guard<std::mutex> lock(hitMutex);
+	return hitList.size();
+}
+
+uint32_t searchEngine::scanned() const {
+	std::lock_guard<std::mutex> lock(hitMutex);
+	return scannedCount;
+}
+
+bool searchEngine::finished() const {
+	std::lock_guard<std::mutex> lock(hitMutex);
+	return done;
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,177 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/snaillog.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the in-memory snail log tables.
+ */
+#include "snailviewer/snaillog.hpp"
+#include "snailviewer/hashing.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace snailviewer {
+
+// Helpers for hashing the objects.
+namespace {
+
+/// The initial number of slots of the object hash table.
+constexpr size_t initialSlots = 1024;
+
+/// Hash the literal object.
+inline uint32_t hashLiteral(uint32_t type,
+		const char* data, size_t length) noexcept {
+	return hashFold(hashBytes(hashMix(0, type), data, length));
+}
+
+/// Hash the structure object.
+inline uint32_t hashStruct(uint32_t type,
+		const objectField* fields, size_t count) noexcept {
+	return hashFold(hashBytes(hashMix(1, type),
+		(const char*)fields, count * sizeof(objectField)));
+}
+
+} // Anonymous namespace.
+
+objectStore::objectStore(): slots(initialSlots, absent) {
+	std::memset(&stats, 0, sizeof(stats));
+}
+
+void objectStore::reindex() {
+	if(hashes.size() != nodes.size()) {
+		hashes.clear();
+		hashes.reserve(nodes.size());
+		for(const objectNode& node : nodes) hashes.push_back(
+			node.trait == objectTrait::structure?
+				hashStruct(node.type, fieldList.data() + node.begin, node.count) :
+				hashLiteral(node.type, heap.data() + node.begin, node.count));
+	}
+	size_t count = initialSlots;
+	while(count < hashes.size() * 2) count *= 2;
+	slots.assign(count, absent);
+	size_t mask = count - 1;
+	for(size_t j = 0; j < hashes.size(); ++ j) {
+		size_t i = hashes[j] & mask;
+		while(slots[i] != absent) i = (i + 1) & mask;
+		slots[i] = (uint32_t)j;
+	}
+}
+
+void objectStore::dropIndex() {
+	std::vector<uint32_t>().swap(hashes);
+	std::vector<uint32_t>().swap(slots);
+}
+
+template<typename matchType>
+uint32_t& objectStore::probe(uint32_t hash, matchType match) {
+	if(slots.empty()) reindex();
+	size_t mask = slots.size() - 1;
+	for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+		uint32_t& slot = slots[i];
+		if(slot == absent) return slot;
+		if(hashes[slot] == hash && match(nodes[slot])) return slot;
+	}
+}
+
+void objectStore::remember(uint32_t& slot, uint32_t hash) {
+	uint32_t id = (uint32_t)(nodes.size() - 1);
+	slot = id;
+	hashes.push_back(hash);
+	++ stats.stored;
+
+	// Keep the load factor of the hash table under a half.
+	if(hashes.size() * 2 > slots.size()) reindex();
+}
+
+uint32_t objectStore::addLiteral(uint32_t type, const char* data, size_t length) {
+	++ stats.added;
+	stats.addedBytes += sizeof(objectNode) + length;
+	uint32_t hash = hashLiteral(type, data, length);
+	uint32_t& slot = probe(hash, [&](const objectNode& node) {
+		return node.trait == objectTrait::literal && node.type == type &&
+			node.count == length && std::memcmp(
+				heap.data() + node.begin, data, length) == 0;
+	});
+	if(slot != absent) return slot;
+
+	if(heap.size() + length > absent)
+		throw std::length_error("The literal heap exceeds 4GiB.");
+	objectNode node;
+	std::memset(&node, 0, sizeof(node));
+	node.trait = objectTrait::literal;
+	node.type = type;
+	node.begin = (uint32_t)heap.size();
+	node.count = (uint32_t)length;
+	heap.append(data, data + length);
+	nodes.push_back(node);
+	stats.storedBytes += sizeof(objectNode) + length;
+	remember(slot, hash);
+	return (uint32_t)(nodes.size() - 1);
+}
+
+uint32_t objectStore::addStruct(uint32_t type,
+		const objectField* fields, size_t count) {
+	++ stats.added;
+	size_t bytes = count * sizeof(objectField);
+	stats.addedBytes += sizeof(objectNode) + bytes;
+	uint32_t hash = hashStruct(type, fields, count);
+	uint32_t& slot = probe(hash, [&](const objectNode& node) {
+		return node.trait == objectTrait::structure && node.type == type &&
+			node.count == count && std::memcmp(fieldList.data()
+				+ node.begin, fields, bytes) == 0;
+	});
+	if(slot != absent) return slot;
+
+	if(fieldList.size() + count > absent)
+		throw std::length_error("The number of fields exceeds 4G.");
+	objectNode node;
+	std::memset(&node, 0, sizeof(node));
+	node.trait = objectTrait::structure;
+	node.type = type;
+	node.begin = (uint32_t)fieldList.size();
+	node.count = (uint32_t)count;
+	fieldList.append(fields, fields + count);
+	nodes.push_back(node);
+	stats.storedBytes += sizeof(objectNode) + bytes;
+	remember(slot, hash);
+	return (uint32_t)(nodes.size() - 1);
+}
+
+void objectStore::borrow(const objectNode* nodeData, size_t nodeCount,
+		const objectField* fieldData, size_t fieldCount,
+		const char* heapData, size_t heapSize) {
+	nodes.borrow(nodeData, nodeCount);
+	fieldList.borrow(fieldData, fieldCount);
+	heap.borrow(heapData, heapSize);
+	dropIndex();
+	std::memset(&stats, 0, sizeof(stats));
+	stats.added = stats.stored = nodeCount;
+	stats.addedBytes = stats.storedBytes = nodeCount * sizeof(objectNode)
+		+ fieldCount * sizeof(objectField) + heapSize;
+}
+
+void objectStore::shrink() {
+	nodes.shrink();
+	fieldList.shrink();
+	heap.shrink();
+	dropIndex();
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,206 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/sourcecache.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the cache of source files.
+ */
+#include "snailviewer/sourcecache.hpp"
+#include <stdexcept>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SNAIL_SCAN_X86 1
+#endif
+
+namespace snailviewer {
+
+// The newline scanners, which find the newlines of 64 bytes as a mask
+// then append the offsets of the bits.
+namespace {
+
+/// The scanner of newlines.
+typedef void (*lineScannerType)(const char* data, size_t size,
+	uint32_t base, table<uint32_t>& starts);
+
+/// Append the line starts after the newlines of the mask.
+inline void appendStarts(uint64_t mask, uint32_t offset, table<uint32_t>& starts) {
+	while(mask != 0) {
+		starts.push_back(offset + (uint32_t)__builtin_ctzll(mask) + 1);
+		mask &= mask - 1;
+	}
+}
+
+/// Scan the newlines byte by byte.
+void scanScalar(const char* data, size_t size,
+		uint32_t base, table<uint32_t>& starts) {
+	for(size_t i = 0; i < size; ++ i)
+		if(data[i] == '\n') starts.push_back(base + (uint32_t)i + 1);
+}
+
+#ifdef SNAIL_SCAN_X86
+/// Scan the newlines 16 bytes at a time.
+__attribute__((target("sse2")))
+void scanSse(const char* data, size_t size,
+		uint32_t base, table<uint32_t>& starts) {
+	const __m128i newline = _mm_set1_epi8('\n');
+	size_t i = 0;
+	for(; i + 64 <= size; i += 64) {
+		uint64_t mask = 0;
+		for(unsigned j = 0; j < 64; j += 16) {
+			__m128i chars = _mm_loadu_si128((const __m128i*)(data + i + j));
+			mask |= uint64_t((uint16_t)_mm_movemask_epi8(
+				_mm_cmpeq_epi8(chars, newline))) << j;
+		}
+		appendStarts(mask, base + (uint32_t)i, starts);
+	}
+	scanScalar(data + i, size - i, base + (uint32_t)i, starts);
+}
+
+/// Scan the newlines 32 bytes at a time.
+__attribute__((target("avx2")))
+void scanAvx2(const char* data, size_t size,
+		uint32_t base, table<uint32_t>& starts) {
+	const __m256i newline = _mm256_set1_epi8('\n');
+	size_t i = 0;
+	for(; i + 64 <= size; i += 64) {
+		__m256i low = _mm256_loadu_si256((const __m256i*)(data + i));
+		__m256i high = _mm256_loadu_si256((const __m256i*)(data + i + 32));
+		uint64_t mask = uint64_t((uint32_t)_mm256_movemask_epi8(
+			_mm256_cmpeq_epi8(low, newline))) | (uint64_t((uint32_t)
+			_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, newline))) << 32);
+		appendStarts(mask, base + (uint32_t)i, starts);
+	}
+	scanScalar(data + i, size - i, base + (uint32_t)i, starts);
+}
+#endif
+
+/// The chosen scanner and its name.
+struct scannerChoice {
+	lineScannerType scan;
+	const char* name;
+};
+
+/// Choose the best scanner supported by the processor.
+scannerChoice chooseScanner() noexcept {
+#ifdef SNAIL_SCAN_X86
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return scannerChoice { scanAvx2, "avx2" };
+	if(__builtin_cpu_supports("sse2"))
+		return scannerChoice { scanSse, "sse" };
+#endif
+	return scannerChoice { scanScalar, "scalar" };
+}
+
+/// The scanner used for indexing.
+const scannerChoice scanner = chooseScanner();
+
+} // Anonymous namespace.
+
+void scanLines(const char* data, size_t size,
+		uint32_t base, table<uint32_t>& starts) {
+	scanner.scan(data, size, base, starts);
+}
+
+const char* lineScanLevel() noexcept { return scanner.name; }
+
+sourceFile::sourceFile(const std::string& path): content(path) {
+	if(content.size() >= 0xffffffffu)
+		throw std::length_error(path + " is too large to view");
+	uint32_t size = (uint32_t)content.size();
+
+	// Roughly 40 characters a line, to avoid most of the reallocations.
+	starts.reserve(size / 40 + 2);
+	starts.push_back(0);
+	scanLines(content.data(), size, 0, starts);
+	if(starts[starts.size() - 1] != size) starts.push_back(size);
+	starts.shrink();
+}
+
+size_t sourceFile::lineLength(size_t line) const {
+	size_t begin = starts[line], end = starts[line + 1];
+	if(end > begin && content.data()[end - 1] == '\n') -- end;
+	if(end > begin && content.data()[end - 1] == '\r') -- end;
+	return end - begin;
+}
+
+constexpr size_t sourceCache::defaultCapacity;
+
+sourceCache::sourceCache(const snailLog& log, size_t capacity):
+	log(log), capacity(capacity) {}
+
+void sourceCache::evict() {
+	while(recent.size() > capacity && recent.size() > 1) {
+		entries.erase(recent.back().first);
+		recent.pop_back();
+	}
+}
+
+std::string sourceCache::path(uint32_t file) const {
+	std::string name(log.files.data(file), log.files.length(file));
+	if(log.root.empty() || (!name.empty() && name[0] == '/')) return name;
+	if(log.root[log.root.size() - 1] == '/') return log.root + name;
+	return log.root + "/" + name;
+}
+
+std::shared_ptr<const sourceFile> sourceCache::get(uint32_t file) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = entries.find(file);
+		if(it != entries.end()) {
+			recent.splice(recent.begin(), recent, it->second);
+			return it->second->second;
+		}
+	}
+
+	// Map and index outside the lock so that other files could be looked
+	// up meanwhile, the first one indexed is kept if both index it.
+	std::shared_ptr<const sourceFile> mapped(new sourceFile(path(file)));
+
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = entries.find(file);
+	if(it != entries.end()) {
+		recent.splice(recent.begin(), recent, it->second);
+		return it->second->second;
+	}
+	recent.push_front(entry(file, mapped));
+	entries.emplace(file, recent.begin());
+	evict();
+	return mapped;
+}
+
+void sourceCache::setCapacity(size_t files) {
+	std::lock_guard<std::mutex> lock(mutex);
+	capacity = files;
+	evict();
+}
+
+size_t sourceCache::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return recent.size();
+}
+
+void sourceCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	entries.clear();
+	recent.clear();
+}
+
+} // namespace snailviewer.
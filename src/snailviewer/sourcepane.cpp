@@ -0,0 +1,136 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/sourcepane.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the source pane.
+ */
+#define NCURSES_NOMACROS
+#include "snailviewer/sourcepane.hpp"
+#include <algorithm>
+#include <system_error>
+#include <stdexcept>
+#include <curses.h>
+
+namespace snailviewer {
+
+// Helpers for rendering the source code.
+namespace {
+
+/// The number of columns of a tab.
+constexpr size_t tabWidth = 4;
+
+/// Append the line with the tabs expanded and the control characters
+/// replaced, up to the limit of columns.
+void appendCode(const char* data, size_t length, size_t limit, std::string& out) {
+	size_t origin = out.size();
+	for(size_t i = 0; i < length && out.size() - origin < limit; ++ i) {
+		char c = data[i];
+		if(c == '\t') out.append(tabWidth - (out.size() - origin) % tabWidth, ' ');
+		else out.push_back((unsigned char)c < 0x20 || c == 0x7f? '?' : c);
+	}
+}
+
+} // Anonymous namespace.
+
+sourcePane::sourcePane(sourceCache& cache): widget(paneId()),
+	cache(cache), fileIndex(absent), currentLine(1), topLine(1) {}
+
+int sourcePane::rowOf(size_t line) const {
+	if(line < topLine || line - topLine + 1 >= (size_t)height()) return -1;
+	return (int)(line - topLine + 1);
+}
+
+std::string sourcePane::rowText(int row) const {
+	std::string text;
+	if(row == 0) {
+		if(fileIndex != absent) {
+			text = cache.path(fileIndex) + ":" + std::to_string(currentLine);
+			if(!message.empty()) text += " (" + message + ")";
+		}
+	} else if(file != nullptr) {
+		size_t line = topLine + (size_t)row - 1;
+		if(line <= file->lines()) {
+			std::string number = std::to_string(line);
+			size_t digits = std::to_string(file->lines()).size();
+			text.append(digits - number.size(), ' ');
+			text += number;
+			text += line == currentLine? " > " : "   ";
+			appendCode(file->lineData(line - 1), file->lineLength(line - 1),
+				(size_t)width(), text);
+		}
+	}
+	text.resize((size_t)width(), ' ');
+	return text;
+}
+
+void sourcePane::paint(cursesWindow* window, const rect& area) {
+	for(int row = area.top; row < area.bottom(); ++ row) {
+		std::string text = rowText(row);
+		bool highlight = row == 0 || (row == rowOf(currentLine) && file != nullptr);
+		if(highlight) wattron(window, A_REVERSE);
+		mvwaddnstr(window, row, area.left, text.c_str() + area.left, area.width);
+		if(highlight) wattroff(window, A_REVERSE);
+	}
+}
+
+void sourcePane::show(uint32_t index, uint32_t line) {
+	size_t target = line == 0 || line == absent? 1 : line;
+	if(index == fileIndex && file != nullptr) {
+		// Only the rows of both lines change when the line is shown.
+		int previous = rowOf(currentLine), current = rowOf(target);
+		currentLine = target;
+		invalidateRow(0);
+		if(previous >= 0 && current >= 0) {
+			invalidateRow(previous);
+			invalidateRow(current);
+			return;
+		}
+	} else {
+		fileIndex = index;
+		currentLine = target;
+		file.reset();
+		message.clear();
+		if(index != absent) try {
+			file = cache.get(index);
+		} catch(const std::system_error& e) {
+			message = e.code().message();
+		} catch(const std::length_error&) {
+			message = "too large";
+		}
+	}
+
+	// Center the line inside the rows of code.
+	size_t rows = height() > 1? (size_t)height() - 1 : 1;
+	topLine = currentLine > rows / 2? currentLine - rows / 2 : 1;
+	invalidate();
+}
+
+void sourcePane::scroll(long rows) {
+	if(file == nullptr) return;
+	long top = (long)topLine + rows;
+	long last = std::max<long>(1, (long)file->lines() - (height() - 1) + 1);
+	top = std::max<long>(1, std::min(top, last));
+	if((size_t)top == topLine) return;
+	topLine = (size_t)top;
+	invalidate(rect { 1, 0, height() - 1, width() });
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,38 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/staticbus.cpp
+ * @author Haoran Luo
+ * @brief Instantiation of the static event bus.
+ *
+ * The bus is instantiated for the built-in events of the viewer here,
+ * so that every member of the template is compiled with the library,
+ * although the viewer itself dispatches them by the priority bus.
+ */
+#include "snailviewer/staticbus.hpp"
+#include "snailviewer/backgroundloader.hpp"
+#include "snailviewer/search.hpp"
+
+namespace snailviewer {
+
+template class staticEventBus<logOpenedEvent, footprintsLoadedEvent,
+	logLoadedEvent, searchHitsEvent>;
+
+} // namespace snailviewer.
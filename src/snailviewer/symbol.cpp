@@ -0,0 +1,96 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/symbol.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the symbol table.
+ */
+#include "snailviewer/symbol.hpp"
+#include "snailviewer/hashing.hpp"
+#include <cstring>
+#include <stdexcept>
+
+namespace snailviewer {
+
+// Helpers for the symbol table.
+namespace {
+
+/// The marker of the empty slots.
+constexpr uint32_t emptySlot = 0xffffffffu;
+
+/// The initial number of slots.
+constexpr size_t initialSlots = 256;
+
+/// Hash the name.
+inline uint32_t hashName(const char* name, size_t length) noexcept {
+	return hashFold(hashBytes(0, name, length));
+}
+
+} // Anonymous namespace.
+
+symbolTable::symbolTable(): slots(initialSlots, emptySlot) {}
+
+void symbolTable::rehash(size_t count) {
+	slots.assign(count, emptySlot);
+	size_t mask = count - 1;
+	for(size_t j = 0; j < names.size(); ++ j) {
+		uint32_t symbol = (uint32_t)j;
+		size_t i = hashName(names.data(symbol), names.length(symbol)) & mask;
+		while(slots[i] != emptySlot) i = (i + 1) & mask;
+		slots[i] = symbol;
+	}
+}
+
+size_t symbolTable::probe(const char* name, size_t length, uint32_t hash) const {
+	size_t mask = slots.size() - 1;
+	for(size_t i = hash & mask; ; i = (i + 1) & mask) {
+		uint32_t symbol = slots[i];
+		if(symbol == emptySlot) return i;
+		if(names.length(symbol) == length && std::memcmp(
+			names.data(symbol), name, length) == 0) return i;
+	}
+}
+
+uint32_t symbolTable::intern(const char* name, size_t length) {
+	size_t i = probe(name, length, hashName(name, length));
+	if(slots[i] != emptySlot) return slots[i];
+	if(names.size() >= emptySlot - 1)
+		throw std::length_error("The number of symbols exceeds 4G.");
+	uint32_t symbol = names.push_back(name, length);
+	slots[i] = symbol;
+
+	// Keep the load factor of the table under a half.
+	if(names.size() * 2 > slots.size()) rehash(slots.size() * 2);
+	return symbol;
+}
+
+uint32_t symbolTable::find(const char* name, size_t length) const {
+	return slots[probe(name, length, hashName(name, length))];
+}
+
+void symbolTable::borrow(const uint64_t* offsets, size_t count,
+		const char* chars, size_t length) {
+	names.borrow(offsets, count, chars, length);
+	size_t slotCount = initialSlots;
+	while(slotCount < count * 2) slotCount *= 2;
+	rehash(slotCount);
+}
+
+} // namespace snailviewer.
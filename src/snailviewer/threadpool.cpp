@@ -0,0 +1,68 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/threadpool.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the thread pool.
+ */
+#include "snailviewer/threadpool.hpp"
+
+namespace snailviewer {
+
+threadPool::threadPool(size_t count): stopping(false) {
+	if(count == 0) count = std::thread::hardware_concurrency();
+	if(count == 0) count = 1;
+	workers.reserve(count);
+	for(size_t i = 0; i < count; ++ i)
+		workers.push_back(std::thread(&threadPool::work, this));
+}
+
+threadPool::~threadPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for(std::thread& worker : workers) worker.join();
+}
+
+void threadPool::enqueue(std::function<void()> task) {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.push_back(std::move(task));
+	}
+	condition.notify_one();
+}
+
+void threadPool::work() {
+	while(true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if(tasks.empty()) return;
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,158 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file snailviewer/widget.cpp
+ * @author Haoran Luo
+ * @brief Implementation of the damage-tracked widgets.
+ */
+#define NCURSES_NOMACROS
+#include "snailviewer/widget.hpp"
+#include <algorithm>
+#include <stdexcept>
+#include <curses.h>
+
+namespace snailviewer {
+
+constexpr size_t damageRegion::maxRects;
+
+rect rect::intersect(const rect& other) const noexcept {
+	int t = std::max(top, other.top), l = std::max(left, other.left);
+	return rect { t, l, std::min(bottom(), other.bottom()) - t,
+		std::min(right(), other.right()) - l };
+}
+
+rect rect::unite(const rect& other) const noexcept {
+	if(empty()) return other;
+	if(other.empty()) return *this;
+	int t = std::min(top, other.top), l = std::min(left, other.left);
+	return rect { t, l, std::max(bottom(), other.bottom()) - t,
+		std::max(right(), other.right()) - l };
+}
+
+void damageRegion::add(const rect& area) {
+	if(area.empty()) return;
+
+	// Absorb the adjoining rectangles until none adjoins, since the
+	// bounding rectangle may adjoin more rectangles.
+	rect merged = area;
+	bool absorbed = true;
+	while(absorbed) {
+		absorbed = false;
+		for(size_t i = 0; i < rects.size(); ++ i) {
+			if(!rects[i].adjoins(merged)) continue;
+			merged = merged.unite(rects[i]);
+			rects[i] = rects.back();
+			rects.pop_back();
+			absorbed = true;
+			break;
+		}
+	}
+	rects.push_back(merged);
+	if(rects.size() > maxRects) {
+		rect all = rects[0];
+		for(const rect& r : rects) all = all.unite(r);
+		rects.assign(1, all);
+	}
+}
+
+widget::~widget() {
+	if(window != nullptr) delwin(window);
+}
+
+void widget::blank(cursesWindow* window, const rect& area) {
+	for(int row = area.top; row < area.bottom(); ++ row)
+		mvwhline(window, row, area.left, ' ', area.width);
+}
+
+void widget::place(const rect& area) {
+	if(window != nullptr) {
+		delwin(window);
+		window = nullptr;
+	}
+	bounds = area;
+	damage.clear();
+	if(area.empty()) return;
+	window = newwin(area.height, area.width, area.top, area.left);
+	if(window == nullptr) throw std::runtime_error("Cannot create window");
+	invalidate();
+}
+
+void widget::invalidate(const rect& area) {
+	damage.add(area.intersect(rect { 0, 0, bounds.height, bounds.width }));
+}
+
+bool widget::render() {
+	if(window == nullptr || damage.empty()) return false;
+	for(const rect& area : damage.areas()) paint(window, area);
+	damage.clear();
+	wnoutrefresh(window);
+	return true;
+}
+
+display::display(FILE* output, FILE* input, const char* type) {
+	terminal = newterm(type, output, input);
+	if(terminal == nullptr) throw std::runtime_error("Cannot open terminal");
+	set_term(terminal);
+	cbreak();
+	noecho();
+	keypad(stdscr, TRUE);
+	curs_set(0);
+
+	// The standard screen is never drawn, while refreshing it on the
+	// first read of key would clear the terminal.
+	wnoutrefresh(stdscr);
+}
+
+display::~display() {
+	endwin();
+	delscreen(terminal);
+}
+
+int display::rows() const { return getmaxy(stdscr); }
+
+int display::columns() const { return getmaxx(stdscr); }
+
+void display::add(widget& w) {
+	if(std::find(widgets.begin(), widgets.end(), &w) == widgets.end())
+		widgets.push_back(&w);
+}
+
+void display::remove(widget& w) {
+	widgets.erase(std::remove(widgets.begin(), widgets.end(), &w), widgets.end());
+}
+
+size_t display::render() {
+	size_t rendered = 0;
+	for(widget* w : widgets) if(w->render()) ++ rendered;
+	if(rendered > 0) doupdate();
+	return rendered;
+}
+
+void display::repaint() {
+	clearok(curscr, TRUE);
+	for(widget* w : widgets) w->invalidate();
+}
+
+int display::readKey(int timeout) {
+	wtimeout(stdscr, timeout);
+	return wgetch(stdscr);
+}
+
+} // namespace snailviewer.
@@ -0,0 +1,136 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/backgroundloader.cpp
+ * @author Haoran Luo
+ * @brief Test of opening a binary log through the background loader.
+ *
+ * The viewer loads with lazy objects, which binary logs never have, so
+ * the loader must report the log opened as eager for the objects to be
+ * shown from the tables instead of decoded from the text.
+ */
+#include "test.hpp"
+#include "snailviewer/backgroundloader.hpp"
+#include "snailviewer/binary.hpp"
+#include "snailviewer/loader.hpp"
+#include "snailviewer/objectcache.hpp"
+#include "snailviewer/objecttree.hpp"
+#include "snailviewer/prioritybus.hpp"
+#include <chrono>
+#include <exception>
+#include <string>
+#include <thread>
+
+using namespace snailviewer;
+
+// Helpers for the background loader test.
+namespace {
+
+/// Fill the log with a footprint binding a point.
+void capture(snailLog& log) {
+	uint32_t intType = log.names.intern("int");
+	uint32_t pointType = log.names.intern("point");
+	objectField fields[2] = {
+		{ log.names.intern("x"), log.objects.addLiteral(intType, "1", 1) },
+		{ log.names.intern("y"), log.objects.addLiteral(intType, "2", 1) },
+	};
+	uint32_t point = log.objects.addStruct(pointType, fields, 2);
+	log.files.push_back("main.cpp");
+	log.functions.push_back("main");
+	log.bindings.push_back(objectBinding { log.names.intern("local"),
+		log.names.intern("p"), point });
+	log.footprints.push_back(absent, 0, 1, 0, 1);
+	log.tree.build(log.footprints);
+}
+
+/// The handler recording the events of loading.
+class loadWatcher : private eventHandler<logOpenedEvent>,
+	private eventHandler<logLoadedEvent> {
+	virtual void handle(const logOpenedEvent& event) override {
+		opened = true;
+		lazy = event.lazy;
+	}
+
+	virtual void handle(const logLoadedEvent& event) override {
+		loaded = true;
+		error = event.error;
+	}
+public:
+	/// Whether the log is opened and loaded.
+	bool opened, loaded;
+
+	/// Whether the log is opened with lazy objects.
+	bool lazy;
+
+	/// The error of loading, or null.
+	std::exception_ptr error;
+
+	/// Watch the events of the bus.
+	explicit loadWatcher(eventBus& bus): eventHandler<logOpenedEvent>(bus),
+		eventHandler<logLoadedEvent>(bus), opened(false), loaded(false),
+		lazy(false) {}
+};
+
+} // Anonymous namespace.
+
+void snailtest::backgroundLoader() {
+	snailLog saved;
+	capture(saved);
+	temporaryFile file;
+	saveBinaryFile(saved, file.path());
+
+	// Load as the viewer does, with lazy objects requested.
+	priorityEventBus bus;
+	loadWatcher watcher(bus);
+	loadOptions options;
+	options.lazyObjects = true;
+	snailviewer::backgroundLoader loader(bus, file.path(), options);
+	auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+	while(!watcher.loaded) {
+		expect(std::chrono::steady_clock::now() < deadline,
+			"The log is not loaded in time.");
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		bus.flush();
+	}
+	if(watcher.error != nullptr) std::rethrow_exception(watcher.error);
+	expect(watcher.opened, "The log is loaded without being opened.");
+	expect(!watcher.lazy, "The binary log is opened as lazy.");
+
+	// The objects are shown from the tables of the binary log.
+	const snailLog& log = loader.target();
+	objectCache cache(log);
+	cache.setLazy(watcher.lazy);
+	objectTreeModel model;
+	model.reset(log, 0, cache);
+	expect(model.rows() == 2, "The scope and binding are not shown.");
+	expect(model.expand(1) == 2, "The fields of the point are not shown.");
+	expect(model.text(model.at(2), 80).find('1') != std::string::npos,
+		"The field of the point is not shown.");
+
+	// Decoding the objects of a binary log is rejected.
+	bool rejected = false;
+	try {
+		decodedObjects decoded;
+		decodeObjects(log, 0, decoded);
+	} catch(const jsonError&) {
+		rejected = true;
+	}
+	expect(rejected, "The objects of the binary log are decoded.");
+}
@@ -0,0 +1,140 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/binary.cpp
+ * @author Haoran Luo
+ * @brief Test of rejecting binary logs with references out of range.
+ *
+ * A binary log is written and then corrupted record by record, where
+ * each corruption must be rejected while opening instead of leading to
+ * reading outside the tables afterwards.
+ */
+#include "test.hpp"
+#include "snailviewer/binary.hpp"
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using namespace snailviewer;
+
+// Helpers for the binary references test.
+namespace {
+
+/// Fill the log with a footprint capturing a point and its callee.
+void capture(snailLog& log) {
+	uint32_t intType = log.names.intern("int");
+	uint32_t pointType = log.names.intern("point");
+	objectField fields[2] = {
+		{ log.names.intern("x"), log.objects.addLiteral(intType, "1", 1) },
+		{ log.names.intern("y"), log.objects.addLiteral(intType, "2", 1) },
+	};
+	uint32_t point = log.objects.addStruct(pointType, fields, 2);
+	log.files.push_back("main.cpp");
+	log.functions.push_back("main");
+	log.functions.push_back("draw");
+	uint32_t local = log.names.intern("local");
+	log.bindings.push_back(objectBinding { local, log.names.intern("p"), point });
+	log.footprints.push_back(absent, 0, 1, 0, 1);
+	log.bindings.push_back(objectBinding { local, log.names.intern("q"), point });
+	log.footprints.push_back(0, 0, 5, 1, 2);
+	log.tree.build(log.footprints);
+}
+
+/// Read the whole content of the file.
+std::string readFile(const std::string& path) {
+	std::ifstream input(path, std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(input),
+		std::istreambuf_iterator<char>());
+}
+
+/// Write the content as the whole file.
+void writeFile(const std::string& path, const std::string& content) {
+	std::ofstream output(path, std::ios::binary | std::ios::trunc);
+	output.write(content.data(), (std::streamsize)content.size());
+}
+
+/// Overwrite the 32-bit value at the offset inside the section.
+std::string corrupt(std::string content, sectionKind kind,
+		size_t offset, uint32_t value) {
+	binaryHeader header;
+	std::memcpy(&header, content.data(), sizeof(header));
+	for(uint32_t i = 0; i < header.sectionCount; ++ i) {
+		binarySection section;
+		std::memcpy(&section, content.data() + sizeof(header) +
+			i * sizeof(section), sizeof(section));
+		if(section.kind != kind) continue;
+		std::memcpy(&content[(size_t)section.offset + offset],
+			&value, sizeof(value));
+		return content;
+	}
+	throw snailtest::failure("The section to corrupt is absent.");
+}
+
+/// Whether opening the content is rejected as malformed.
+bool rejected(const std::string& path, const std::string& content) {
+	writeFile(path, content);
+	try {
+		snailLog log;
+		loadBinaryFile(path, log);
+	} catch(const formatError&) {
+		return true;
+	}
+	return false;
+}
+
+} // Anonymous namespace.
+
+void snailtest::binaryReferences() {
+	snailLog saved;
+	capture(saved);
+	temporaryFile file;
+	saveBinaryFile(saved, file.path());
+	std::string content = readFile(file.path());
+	expect(!rejected(file.path(), content), "The intact log is rejected.");
+
+	// The object nodes are {trait, type, begin, count} of 16 bytes.
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::objectNodes, 12, 1000)),
+		"The literal out of the heap is accepted.");
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::objectNodes, 4, 1000)),
+		"The type out of the names is accepted.");
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::objectFields, 4, 1000)),
+		"The field object out of range is accepted.");
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::bindings, 8, 1000)),
+		"The bound object out of range is accepted.");
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::footprintBindings, 4, 1000)),
+		"The bindings out of range are accepted.");
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::footprintFunctions, 4, 1000)),
+		"The function out of range is accepted.");
+
+	// The tree index is borrowed, so it must agree with the parents.
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::treeEnters, 4, 0)),
+		"The inconsistent pre-order is accepted.");
+	expect(rejected(file.path(), corrupt(content,
+		sectionKind::treeChildren, 0, 0)),
+		"The inconsistent children are accepted.");
+}
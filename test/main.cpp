@@ -0,0 +1,68 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/main.cpp
+ * @author Haoran Luo
+ * @brief Entry point of the tests.
+ */
+#include "test.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+// Helpers for running the tests.
+namespace {
+
+/// The test with its name.
+struct testCase {
+	/// The name to select the test by.
+	const char* name;
+
+	/// Run the test, raising the failure if it has failed.
+	void (*run)();
+};
+
+/// The tests in the order to run.
+const testCase tests[] = {
+	{ "backgroundloader", snailtest::backgroundLoader },
+	{ "binaryreferences", snailtest::binaryReferences },
+};
+
+} // Anonymous namespace.
+
+// Implementation of the test entry point.
+int main(int argc, char* argv[]) {
+	bool passed = true;
+	for(const testCase& test : tests) {
+		bool selected = argc <= 1;
+		for(int i = 1; i < argc; ++ i)
+			if(std::strcmp(argv[i], test.name) == 0) selected = true;
+		if(!selected) continue;
+		try {
+			test.run();
+			std::printf("%s: passed\n", test.name);
+		} catch(const std::exception& e) {
+			std::printf("%s: failed: %s\n", test.name, e.what());
+			passed = false;
+		}
+	}
+	return passed? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,78 @@
+/*
+ * @Snail@ - Code Execution Footprint Tracer & Explorer.
+ *
+ * Copyright (C) 2018 Haoran Luo
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file test/test.hpp
+ * @author Haoran Luo
+ * @brief The tests of the snail viewer.
+ *
+ * The tests are built into a single executable when BUILD_TEST is on,
+ * which runs the tests named by its arguments, or all of them if none
+ * is named. Each of them is also registered to CTest by its name.
+ */
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+namespace snailtest {
+
+/// The error raised when an expectation of a test is not met.
+class failure : public std::runtime_error {
+public:
+	explicit failure(const std::string& what): std::runtime_error(what) {}
+};
+
+/// Raise the failure with the message unless the condition holds.
+inline void expect(bool condition, const std::string& what) {
+	if(!condition) throw failure(what);
+}
+
+/// The temporary file created for a test, removed afterwards.
+class temporaryFile {
+	/// The path of the file.
+	std::string filePath;
+public:
+	/// Create the empty temporary file.
+	temporaryFile() {
+		char name[] = "/tmp/snailtest.XXXXXX";
+		int fd = mkstemp(name);
+		expect(fd >= 0, "Cannot create the temporary file.");
+		close(fd);
+		filePath = name;
+	}
+
+	/// Remove the temporary file.
+	~temporaryFile() { std::remove(filePath.c_str()); }
+
+	temporaryFile(const temporaryFile&) = delete;
+	temporaryFile& operator=(const temporaryFile&) = delete;
+
+	/// Retrieve the path of the file.
+	const std::string& path() const noexcept { return filePath; }
+};
+
+/// Test rejecting the binary logs with references out of range.
+void binaryReferences();
+
+/// Test opening a binary log through the background loader and showing
+/// the objects of its footprint.
+void backgroundLoader();
+
+} // namespace snailtest.